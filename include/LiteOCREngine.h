@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
 #include <string>
 #include <vector>
 #include <memory>
@@ -11,11 +15,119 @@ namespace LiteOCR {
         int gpuDeviceId = -1; // -1 means CPU
         bool useFp16 = false;
         bool useInt8 = false;
+        int detLimitSideLen = 0; // longest image side fed to the detector, 0 means no limit
+        int detMaxPixels = 0; // pixel budget of the detector input, 0 means no limit
+        int detTileSize = 0; // detect images larger than this on overlapping tiles, 0 disables tiling
+        int detTileOverlap = 128; // overlap between neighbouring tiles, should exceed the text line height
+        float detCoarseScale = 0.f; // first detection pass at this scale, then refine at full resolution, 0 disables
+        float detFineMinHeight = 16.f; // coarse boxes with lower text height in pixels are detected again at full resolution
+        float detFineScore = 0.7f; // coarse boxes with lower score are detected again at full resolution
+        int detPostScale = 1; // 2 or 4 runs DB post-processing on a 1/2 or 1/4 scale probability map
+        int recBatchSize = 8; // max text lines scheduled together as one recognition unit, each inferred at its own width
+        int recBucketWidth = 32; // width granularity for grouping lines into recognition units, not a padded input width
+        float oriMinAspect = 0.f; // lines with width / height below this skip the classifier and are read as they are, accuracy traded for speed: an upside-down short line reads wrong. 0 classifies every line
+        int schedulerSlots = 0; // detector calls / recognition batches running at once over all requests, waiters go by priority. 0 means no limit
+        int poolCapMB = 64; // freed ncnn blobs each execution context keeps for reuse, 0 returns every blob to the heap
+        bool countAllocations = false; // fill RequestOption::allocations, installs a counting cv::Mat allocator for the whole process
+        int recognizerBudgetMB = 0; // registered recognizers loaded at once, least recently used are unloaded past this. 0 means no limit
+        bool useMmap = false; // map .bin files read only instead of reading them, engines loading the same files share the weight pages
+        int numWorkers = 1; // worker threads for line level parallel paths, each worker runs ncnn single threaded. async requests run on the same max(1, numWorkers - 1) pool threads
+    };
+
+    // layout of raw 8 bit pixels, read in place without a conversion copy
+    enum class PixelFormat {
+        BGR = 0,
+        RGB,
+        Gray,
+        BGRA,
+        RGBA,
+    };
+
+    // copies share one flag, cancel() stops every request started with any of them
+    class CancelToken {
+    public:
+        CancelToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+
+        void cancel() const { flag->store(true); }
+        bool cancelled() const { return flag->load(std::memory_order_relaxed); }
+
+    private:
+        std::shared_ptr<std::atomic<bool>> flag;
+    };
+
+    enum class RequestStatus {
+        Ok = 0,
+        Cancelled, // stopped by the cancel token, results are partial
+        TimedOut, // time budget used up, results are partial
+        Dropped, // past the deadline before it could finish, results are empty
+        Failed, // RequestOption::language is not registered or its recognizer failed to load, results are empty
+    };
+
+    // heap allocations made while working on one request
+    struct RequestAllocations {
+        uint64_t matAllocations = 0; // cv::Mat buffers, only counted with InferOption::countAllocations
+        uint64_t blobAllocations = 0; // ncnn blobs not served from a context pool
+    };
+
+    struct RequestOption {
+        int priority = 0; // higher goes first when requests wait for a scheduler slot
+        int deadlineMs = 0; // dropped with an empty result once this many ms passed since the call, 0 means no deadline
+        int timeBudgetMs = 0; // stop after this many ms and return what is done so far, 0 means no budget
+        CancelToken cancel; // checked between contours, text lines and decoder steps
+        RequestAllocations* allocations = nullptr; // filled when the request completes, must outlive it
+        std::string language; // registered recognizer to read the lines with, empty uses the one given to loadModel
+    };
+
+    struct SchedulerStats {
+        struct Stage {
+            size_t queueDepth = 0; // units waiting for a slot right now
+            size_t maxQueueDepth = 0;
+            int running = 0;
+            uint64_t admitted = 0;
+            uint64_t dropped = 0; // requests dropped at this stage for their deadline
+            double totalWaitMs = 0; // over all admitted units
+            double maxWaitMs = 0;
+        };
+        Stage detect; // one unit per detector call
+        Stage recognize; // one unit per group of lines scheduled together
+    };
+
+    struct AllocatorStats {
+        uint64_t heapAllocations = 0; // ncnn blobs taken from the heap
+        uint64_t pooledAllocations = 0; // ncnn blobs served from a pool
+        uint64_t released = 0; // pooled blocks given back to the heap over the cap
+        size_t retainedBytes = 0; // held by the pools right now
+    };
+
+    struct RecognizerStats {
+        std::vector<std::string> loaded; // registered languages in memory, most recently used first
+        size_t loadedBytes = 0; // weights and vocab of those, as charged to recognizerBudgetMB
+        uint64_t loads = 0;
+        uint64_t evictions = 0; // unloaded to stay within the budget
+    };
+
+    // synthetic inputs run by warmup
+    struct WarmupOption {
+        std::vector<int> detectorSides = {640, 1280}; // longest side of the synthetic pages detected, one page each
+        int recognizerMaxWidth = 320; // one full group of lines at every recognizer bucket width up to this
+    };
+
+    // wall time of loading and warming each loaded stage, in pipeline order
+    struct StartupStats {
+        struct Stage {
+            std::string name; // bundle, detector, recognizer, orientation, vocab or table
+            double loadMs = 0;
+            double warmupMs = 0;
+        };
+        std::vector<Stage> stages;
+        bool warm = false; // warmup() has run
     };
 
     struct Textline {
         std::string text;
         std::vector<float> anchors; // position for each character in textline
+        std::vector<float> scores; // confidence for each character in textline
+        float score = 0.f; // mean character confidence, 0 for an empty line
     };
 
     struct TextBox {
@@ -54,24 +166,137 @@ namespace LiteOCR {
                        const char* oriParamPath = nullptr, const char* oriBinPath = nullptr,
                        const InferOption &opt = InferOption());
 
+        // param buffers are NUL terminated text. weights are read in place from the bin buffers,
+        // which must stay valid until the engine is destroyed or loaded again
         bool loadModelFromBuffer(const char* detParamBuffer, const unsigned char* detBinBuffer,
                                  const char* recParamBuffer, const unsigned char* recBinBuffer,
                                  const char* vocabBuffer,
                                  const char* oriParamBuffer = nullptr, const unsigned char* oriBinBuffer = nullptr,
                                  const InferOption &opt = InferOption());
 
-        std::pair<std::vector<TextBox>, std::vector<Textline>> recognize(const void *cvMat);
+        // every model and the vocab from one packBundle file, mapped in one piece and read in place
+        // whatever InferOption::useMmap says. the orientation model is loaded when the bundle has one
+        bool loadBundle(const char* bundlePath, const InferOption &opt = InferOption());
+
+        // loads a new model set with the options of the first load and swaps it in, safe while
+        // recognize runs on other threads. requests already running finish on the old models,
+        // which are freed with the last of them. the new set is warmed first when warmup has run.
+        // on failure the current models keep serving. registered languages are not reloaded
+        bool reloadModel(const char* detParamPath, const char* detBinPath,
+                         const char* recParamPath, const char* recBinPath,
+                         const char* vocabPath,
+                         const char* oriParamPath = nullptr, const char* oriBinPath = nullptr);
+        bool reloadBundle(const char* bundlePath);
+
+        // status tells whether the result is complete, partial results keep every detected box,
+        // lines not recognized in time have empty text.
+        // thread safe once loaded: weights and vocab are shared by all callers, each call leases
+        // its own execution context (extractor allocators and scratch buffers), so memory does not
+        // grow with the number of calling threads beyond those contexts. loading must not overlap
+        // with recognize. with N concurrent callers, numThreads around cores / N avoids oversubscription
+        std::pair<std::vector<TextBox>, std::vector<Textline>> recognize(const void *cvMat, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
+
+        // channels 1, 3 or 4 means gray, BGR or BGRA
+        std::pair<std::vector<TextBox>, std::vector<Textline>> recognize(const unsigned char* imgData, int width, int height, int channels, int cstep, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
+
+        // stride is the byte distance between rows, 0 means tightly packed
+        std::pair<std::vector<TextBox>, std::vector<Textline>> recognize(const unsigned char* imgData, int width, int height, PixelFormat format, int stride, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
+
+        std::pair<std::vector<TextBox>, std::vector<Textline>> recognize(const unsigned char* imgData, int size, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
+
+        // one result per cv::Mat, detection runs per image and the text lines of all images are
+        // scheduled together in shared groups, which pays off for many images with few lines each.
+        // req and status cover the whole batch, a cancelled or timed out batch keeps every
+        // detected box and the lines recognized so far, a dropped or failed one is all empty
+        std::vector<std::pair<std::vector<TextBox>, std::vector<Textline>>> recognizeBatch(const std::vector<const void*> &cvMats, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
 
-        std::pair<std::vector<TextBox>, std::vector<Textline>> recognize(const unsigned char* imgData, int width, int height, int channels, int cstep);
+        // queued on the engine's worker pool, the calling thread returns at once. the cv::Mat
+        // pixels are not copied and must stay valid until the request completes, encoded
+        // images are copied. callbacks run on a pool thread and should not block
+        std::future<std::pair<std::vector<TextBox>, std::vector<Textline>>> recognizeAsync(const void *cvMat, const RequestOption &req = RequestOption());
 
-        std::pair<std::vector<TextBox>, std::vector<Textline>> recognize(const unsigned char* imgData, int size);
+        std::future<std::pair<std::vector<TextBox>, std::vector<Textline>>> recognizeAsync(const unsigned char* imgData, int size, const RequestOption &req = RequestOption());
+
+        void recognizeAsync(const void *cvMat, std::function<void(std::pair<std::vector<TextBox>, std::vector<Textline>>)> callback, const RequestOption &req = RequestOption());
+
+        void recognizeAsync(const unsigned char* imgData, int size, std::function<void(std::pair<std::vector<TextBox>, std::vector<Textline>>)> callback, const RequestOption &req = RequestOption());
+
+        // queue depth and wait time of the scheduler stages, for tuning schedulerSlots
+        SchedulerStats schedulerStats() const;
+
+        // ncnn blob allocations of all execution contexts so far
+        AllocatorStats allocatorStats() const;
+
+        // recognizer and vocab for RequestOption::language, loaded on the first request naming it
+        // with the options given to loadModel. the detector and orientation model are shared by
+        // every language. register after loading, a new load starts with no languages
+        void registerRecognizer(const std::string &language, const char* paramPath, const char* binPath, const char* vocabPath);
+
+        // rec.param, rec.bin and rec.vocab of a packBundle file
+        void registerRecognizerBundle(const std::string &language, const char* bundlePath);
+
+        RecognizerStats recognizerStats() const;
+
+        // runs synthetic pages and lines through every loaded stage on as many execution contexts
+        // as requests use (numWorkers), so the first real request does not pay for first-run
+        // allocations and page faults. blocks until done, must not overlap with loading
+        StartupStats warmup(const WarmupOption &opt = WarmupOption());
+
+        // load times since the last load, and warm-up times once warmup has run
+        StartupStats startupStats() const;
 
         static std::string mergeTextBox(const std::vector<TextBox>& textBoxes);
 
     private:
+        friend class LiteOCRStream;
         std::unique_ptr<LiteOCREngineImpl> impl; 
     };
 
+    struct StreamOption {
+        int queueDepth = 2; // images waiting between two stages, a full queue blocks the stage before it
+        int decodeThreads = 1; // threads decoding and converting input images
+        int detectThreads = 1; // threads running the detector
+        int detectNumThreads = 2; // ncnn threads per detector call
+        int cropThreads = 1; // threads cropping lines and running the orientation classifier
+        int cropNumThreads = 1; // ncnn threads per orientation classifier call
+        int recognizeThreads = 1; // threads running the recognizer
+        int recognizeNumThreads = 2; // ncnn threads per recognizer call
+    };
+
+    struct StreamResult {
+        uint64_t id;
+        std::vector<TextBox> textBoxes;
+        std::vector<Textline> textlines;
+    };
+
+    class LiteOCRStreamImpl;
+
+    // decode -> detect -> crop -> recognize pipeline over a loaded engine, every stage runs on
+    // its own threads so image N + 1 is detected while the lines of image N are recognized.
+    // results come out in completion order, tagged with the id given to push
+    class LiteOCRStream {
+    public:
+        // the engine must be loaded and outlive the stream
+        explicit LiteOCRStream(LiteOCREngine &engine, const StreamOption &opt = StreamOption());
+        // stops all stages, results not popped yet are dropped
+        ~LiteOCRStream();
+
+        // block while the first queue is full, false after close. the pixels are not copied and
+        // must stay valid until the result of this id is popped
+        bool push(uint64_t id, const void *cvMat);
+        // encoded image, the bytes are copied
+        bool push(uint64_t id, const unsigned char* imgData, int size);
+
+        // no more input, pop still returns the images in flight
+        void close();
+
+        // block until the next result, false once closed and drained
+        bool pop(StreamResult &result);
+
+    private:
+        std::unique_ptr<LiteOCRStreamImpl> impl;
+    };
+
     class LiteOCRTableEngineImpl;
 
     class LiteOCRTableEngine {
@@ -84,19 +309,51 @@ namespace LiteOCR {
                        const char* vocabPath,
                        const InferOption &opt = InferOption());
 
+        // same buffer rules as LiteOCREngine::loadModelFromBuffer
         bool loadModelFromBuffer(const char* cnnParamBuffer, const unsigned char* cnnBinBuffer,
                                  const char* slaheadParamBuffer, const unsigned char* slaheadBinBuffer,
                                  const char* vocabBuffer,
                                  const InferOption &opt = InferOption());
 
-        std::pair<std::string,std::vector<Rect>> recognize(const void *cvMat, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult);
+        // the table models of a packBundle file, the OCR entries are ignored
+        bool loadBundle(const char* bundlePath, const InferOption &opt = InferOption());
 
-        std::pair<std::string,std::vector<Rect>> recognize(const unsigned char* imgData, int width, int height, int channels, int cstep, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult);
+        // the structure decoder stops between steps on cancel or budget, the table then holds the cells found so far
+        std::pair<std::string,std::vector<Rect>> recognize(const void *cvMat, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
 
-        std::pair<std::string,std::vector<Rect>> recognize(const unsigned char* imgData, int size, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult);
+        std::pair<std::string,std::vector<Rect>> recognize(const unsigned char* imgData, int width, int height, int channels, int cstep, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
+
+        std::pair<std::string,std::vector<Rect>> recognize(const unsigned char* imgData, int size, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, const RequestOption &req = RequestOption(), RequestStatus *status = nullptr);
+
+        AllocatorStats allocatorStats() const;
+
+        // one synthetic table page through the structure model, see LiteOCREngine::warmup
+        StartupStats warmup();
+
+        StartupStats startupStats() const;
     
     private:
         std::unique_ptr<LiteOCRTableEngineImpl> impl;
     };
 
+    // model files for packBundle, null ones are left out of the bundle
+    struct BundleFiles {
+        const char* detParam = nullptr;
+        const char* detBin = nullptr;
+        const char* recParam = nullptr;
+        const char* recBin = nullptr;
+        const char* vocab = nullptr;
+        const char* oriParam = nullptr;
+        const char* oriBin = nullptr;
+        const char* tableCnnParam = nullptr;
+        const char* tableCnnBin = nullptr;
+        const char* tableHeadParam = nullptr;
+        const char* tableHeadBin = nullptr;
+        const char* tableVocab = nullptr;
+    };
+
+    // packs the files into one aligned bundle with an index, vocabs are split into tokens ahead
+    // of time. one bundle can serve both LiteOCREngine::loadBundle and LiteOCRTableEngine::loadBundle
+    bool packBundle(const BundleFiles &files, const char* bundlePath);
+
 } // namespace LiteOCR
\ No newline at end of file
@@ -1,19 +1,206 @@
 #pragma once
 
 #include "LiteOCREngine.h"
+#include "MappedFile.h"
+#include "PoolAllocator.h"
+#include "Request.h"
 
 #include <ncnn/net.h>
 #include <opencv2/core.hpp>
+#include <cstddef>
+#include <memory>
+#include <mutex>
 #include <tuple>
 #include <vector>
 
 namespace LiteOCR {
+    // OpenCV and std buffers of one context. create() with the size and type a buffer already
+    // has reuses its memory, so a steady stream of similar pages stops allocating
+    struct ScratchBuffers {
+        cv::Mat map, binary; // DB post-processing
+        std::vector<unsigned char> mask; // contour score mask, only as large as the largest box
+        std::vector<std::vector<cv::Point>> contours;
+        std::vector<ptrdiff_t> warpOffsets; // bilinear taps of one row in warp_affine_normalize
+        std::vector<float> warpWeights;
+    };
+
+    // per call execution state, one loaded ncnn::Net can serve many contexts at the same time
+    struct ExecContext {
+        int numThreads = 0; // ncnn threads of this call, 0 keeps the model default
+        // blobs of every extractor run on this context, kept pooled for the next call
+        CappedPoolAllocator blobAllocator{false};
+        CappedPoolAllocator workspaceAllocator{true};
+        ncnn::Mat detectorOutput; // backs the map returned by the last detector forward
+        std::vector<ncnn::Mat> recognizerOutputs; // back the matrices returned by the last forwardCrops / forwardLines
+        ScratchBuffers scratch;
+        RequestState* request = nullptr; // polled between lines, may be null
+    };
+
+    inline bool stop_requested(ExecContext* ctx) {
+        return ctx && ctx->request && ctx->request->stopped();
+    }
+
+    inline void setup_extractor(ncnn::Extractor& ex, ExecContext* ctx) {
+        if (!ctx) {
+            return;
+        }
+        if (ctx->numThreads > 0) {
+            ex.set_num_threads(ctx->numThreads);
+        }
+        ex.set_blob_allocator(&ctx->blobAllocator);
+        ex.set_workspace_allocator(&ctx->workspaceAllocator);
+    }
+
+    // free list of execution contexts, a leased context belongs to one thread until the lease
+    // ends and then keeps its warm allocators for the next caller
+    class ExecContextPool {
+    public:
+        class Lease {
+        public:
+            Lease(ExecContextPool& pool, std::unique_ptr<ExecContext> ctx) : pool(&pool), ctx(std::move(ctx)) {}
+            Lease(Lease&& other) noexcept = default;
+            Lease& operator=(Lease&&) = delete;
+            ~Lease() {
+                if (ctx) {
+                    pool->release(std::move(ctx));
+                }
+            }
+
+            ExecContext& operator*() const { return *ctx; }
+            ExecContext* operator->() const { return ctx.get(); }
+            ExecContext* get() const { return ctx.get(); }
+
+        private:
+            ExecContextPool* pool;
+            std::unique_ptr<ExecContext> ctx;
+        };
+
+        Lease acquire() {
+            std::unique_ptr<ExecContext> ctx;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!contexts.empty()) {
+                    ctx = std::move(contexts.back());
+                    contexts.pop_back();
+                }
+            }
+            if (!ctx) {
+                ctx.reset(new ExecContext());
+                std::lock_guard<std::mutex> lock(mutex);
+                setup(*ctx);
+            }
+            ctx->numThreads = 0;
+            ctx->request = nullptr;
+            return Lease(*this, std::move(ctx));
+        }
+
+        // cap of the blob pools of every context
+        void configure(size_t capBytes) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cap = capBytes;
+            for (auto& ctx : contexts) {
+                setup(*ctx);
+            }
+        }
+
+        AllocatorStats allocatorStats() const {
+            return counters.snapshot();
+        }
+
+        // idle contexts, at most one per thread which ever ran at the same time
+        size_t idle() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return contexts.size();
+        }
+
+    private:
+        void release(std::unique_ptr<ExecContext> ctx) {
+            ctx->detectorOutput.release();
+            ctx->recognizerOutputs.clear();
+            std::lock_guard<std::mutex> lock(mutex);
+            contexts.push_back(std::move(ctx));
+        }
+
+        // caller holds the lock
+        void setup(ExecContext& ctx) {
+            ctx.blobAllocator.setCap(cap);
+            ctx.blobAllocator.setCounters(&counters);
+            ctx.workspaceAllocator.setCap(cap);
+            ctx.workspaceAllocator.setCounters(&counters);
+        }
+
+        std::mutex mutex;
+        // declared before the contexts so it outlives their allocators
+        AllocatorCounters counters;
+        size_t cap = 64u << 20;
+        std::vector<std::unique_ptr<ExecContext>> contexts;
+    };
+
+    inline int pixel_channels(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::Gray: return 1;
+            case PixelFormat::BGRA:
+            case PixelFormat::RGBA: return 4;
+            default: return 3;
+        }
+    }
+
+    // what the cv::Mat entry points assume, the channel count is all they tell
+    inline PixelFormat default_format(int channels) {
+        return channels == 1 ? PixelFormat::Gray : (channels == 4 ? PixelFormat::BGRA : PixelFormat::BGR);
+    }
+
+    // ncnn::Mat::from_pixels type reading format into BGR planes
+    inline int ncnn_bgr_type(PixelFormat format) {
+        switch (format) {
+            case PixelFormat::RGB: return ncnn::Mat::PIXEL_RGB2BGR;
+            case PixelFormat::Gray: return ncnn::Mat::PIXEL_GRAY2BGR;
+            case PixelFormat::BGRA: return ncnn::Mat::PIXEL_BGRA2BGR;
+            case PixelFormat::RGBA: return ncnn::Mat::PIXEL_RGBA2BGR;
+            default: return ncnn::Mat::PIXEL_BGR;
+        }
+    }
+
+    // one text line sampled out of the input image, crop pixel (x, y) reads the image at
+    // (m[0] * x + m[1] * y + m[2], m[3] * x + m[4] * y + m[5])
+    struct TextlineCrop {
+        cv::Mat image;
+        float m[6];
+        int width;
+        int height;
+        PixelFormat format = PixelFormat::BGR; // of image, models see BGR either way
+    };
+
+    // bilinear sampling with replicated border, writes (pixel - mean) * norm as BGR planes into
+    // the first width columns of dst in one pass. the taps are gathered per pixel, blending and
+    // normalization run four pixels at a time on SSE2 / NEON. the row tables live on ctx when given
+    void warp_affine_normalize(const cv::Mat& image, PixelFormat format, const float m[6], int width, int height,
+                               const float mean_vals[3], const float norm_vals[3], ncnn::Mat& dst, ExecContext* ctx = nullptr);
+    // u8 BGR pixels of the crop, for models which still take a cv::Mat
+    cv::Mat warp_crop(const TextlineCrop& crop);
+    // matrix sampling the crop resized by 1 / scale, pixel centers aligned like cv::resize
+    void scale_crop(const TextlineCrop& crop, float scale_x, float scale_y, float m[6]);
+    void rotate_crop_180(TextlineCrop& crop);
+
+    // colour decode straight from the caller's bytes, no copy of the file. reduction 2, 4 or 8
+    // decodes at that fraction of the size, which JPEG does for a fraction of the cost
+    cv::Mat decode_image(const unsigned char* data, int size, int reduction = 1);
+    // size from the JPEG frame header without decoding, false for other formats
+    bool jpeg_size(const unsigned char* data, int size, int& width, int& height);
+    // largest of 1, 2, 4, 8 not above factor
+    int decode_reduction(double factor);
+
+    // weights of net from binPath. with InferOption::useMmap the file is mapped into weights and
+    // ncnn reads the weights in place, so weights must stay alive as long as net does
+    bool load_weights(ncnn::Net& net, const char* binPath, MappedFile& weights, const InferOption& opt);
+
     class BaseDetector {
     public:
+        // with ctx the returned map may view memory owned by ctx, valid until its next detector forward
         virtual ~BaseDetector() = default;
         virtual bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt) = 0;
         virtual bool loadModelFromBuffer(const char *paramBuffer, const unsigned char *binBuffer, const InferOption &opt) = 0;
-        virtual cv::Mat forward(const cv::Mat& input) = 0;
+        virtual cv::Mat forward(const cv::Mat& input, ExecContext* ctx = nullptr, PixelFormat format = PixelFormat::BGR) = 0;
 
     };
 
@@ -23,7 +210,26 @@ namespace LiteOCR {
         virtual bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt) = 0;
         virtual bool loadModelFromBuffer(const char* paramBuffer,const unsigned char* binBuffer, const InferOption &opt) = 0;
 
-        virtual cv::Mat forward(const cv::Mat& input) = 0;
+        virtual cv::Mat forward(const cv::Mat& input, ExecContext* ctx = nullptr) = 0;
+        // lines scheduled together, each inferred at its own width: one output per input, the
+        // same as forward of that input alone. no multi-sample inference, so no batch speedup
+        virtual std::vector<cv::Mat> forwardLines(const std::vector<cv::Mat>& inputs, ExecContext* ctx = nullptr) {
+            std::vector<cv::Mat> outputs;
+            outputs.reserve(inputs.size());
+            for (const auto& input : inputs) {
+                outputs.push_back(forward(input, ctx));
+            }
+            return outputs;
+        }
+        // crops are sampled from their source image by the recognizer itself
+        virtual std::vector<cv::Mat> forwardCrops(const std::vector<TextlineCrop>& crops, ExecContext* ctx = nullptr) {
+            std::vector<cv::Mat> inputs;
+            inputs.reserve(crops.size());
+            for (const auto& crop : crops) {
+                inputs.push_back(warp_crop(crop));
+            }
+            return forwardLines(inputs, ctx);
+        }
     };
 
     class BaseClassifier {
@@ -32,7 +238,16 @@ namespace LiteOCR {
         virtual bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt) = 0;
         virtual bool loadModelFromBuffer(const char* paramBuffer,const unsigned char* binBuffer, const InferOption &opt) = 0;
 
-        virtual int forward(const cv::Mat& input) = 0;
+        virtual int forward(const cv::Mat& input, ExecContext* ctx = nullptr) = 0;
+        // one label per crop, models sampling the crops themselves share one extractor
+        virtual std::vector<int> forwardCrops(const std::vector<TextlineCrop>& crops, ExecContext* ctx = nullptr) {
+            std::vector<int> labels;
+            labels.reserve(crops.size());
+            for (const auto& crop : crops) {
+                labels.push_back(forward(warp_crop(crop), ctx));
+            }
+            return labels;
+        }
     };
 
     class PaddleDetector : public BaseDetector {
@@ -42,15 +257,20 @@ namespace LiteOCR {
 
         bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt) override;
         bool loadModelFromBuffer(const char *paramBuffer, const unsigned char *binBuffer, const InferOption &opt) override;
-        cv::Mat forward(const cv::Mat& input) override;
+        cv::Mat forward(const cv::Mat& input, ExecContext* ctx = nullptr, PixelFormat format = PixelFormat::BGR) override;
 
     private:
+        MappedFile weights; // declared first, the net reads from it until destroyed
         ncnn::Net model;
 
         const float mean_vals[3] = {0.485f * 255.f, 0.456f * 255.f, 0.406f * 255.f};
         const float norm_vals[3] = {1 / (0.229f * 255.f), 1 / (0.224f * 255.f), 1 / (0.225f * 255.f)};
 
         const int stride = 32;
+
+        // large inputs are downscaled before detection, output keeps the downscaled size
+        int limit_side_len = 0;
+        int max_pixels = 0;
     };
 
     class PaddleRecognizer : public BaseRecognizer {
@@ -60,8 +280,14 @@ namespace LiteOCR {
 
         bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt) override;
         bool loadModelFromBuffer(const char* paramBuffer,const unsigned char* binBuffer, const InferOption &opt) override;
-        cv::Mat forward(const cv::Mat& input) override;
+        cv::Mat forward(const cv::Mat& input, ExecContext* ctx = nullptr) override;
+        std::vector<cv::Mat> forwardLines(const std::vector<cv::Mat>& inputs, ExecContext* ctx = nullptr) override;
+        std::vector<cv::Mat> forwardCrops(const std::vector<TextlineCrop>& crops, ExecContext* ctx = nullptr) override;
     private:
+        // runs one normalized line on ex, the output views ctx->recognizerOutputs[index] when ctx is given
+        cv::Mat extract_line(ncnn::Extractor& ex, const ncnn::Mat& in, size_t index, ExecContext* ctx);
+
+        MappedFile weights; // outlives model
         ncnn::Net model;
 
         const float mean_vals[3] = {0.5f * 255.f, 0.5f * 255.f, 0.5f * 255.f};
@@ -77,14 +303,17 @@ namespace LiteOCR {
 
         bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt) override;
         bool loadModelFromBuffer(const char* paramBuffer,const unsigned char* binBuffer, const InferOption &opt) override;
-        int forward(const cv::Mat& input) override;
+        int forward(const cv::Mat& input, ExecContext* ctx = nullptr) override;
+        std::vector<int> forwardCrops(const std::vector<TextlineCrop>& crops, ExecContext* ctx = nullptr) override;
     private:
+        MappedFile weights; // outlives model
         ncnn::Net model;
 
         const float mean_vals[3] = {0.5f * 255.f, 0.5f * 255.f, 0.5f * 255.f};
         const float norm_vals[3] = {1 / (0.5f * 255.f), 1 / (0.5f * 255.f), 1 / (0.5f * 255.f)};
         const int target_width = 160;
         const int target_height = 80;
+        const float max_downscale = 3.0f;
     };
 
     class PaddleDocORI : public BaseClassifier {
@@ -94,8 +323,9 @@ namespace LiteOCR {
 
         bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt) override;
         bool loadModelFromBuffer(const char* paramBuffer,const unsigned char* binBuffer, const InferOption &opt) override;
-        int forward(const cv::Mat& input) override;
+        int forward(const cv::Mat& input, ExecContext* ctx = nullptr) override;
     private:
+        MappedFile weights; // outlives model
         ncnn::Net model;
 
         const float mean_vals[3] = {0.5 * 255.f, 0.5 * 255.f, 0.5 * 255.f};
@@ -112,18 +342,47 @@ namespace LiteOCR {
 
         bool loadModel(const char* paramPath, const char* binPath, const InferOption &opt);
         bool loadModelFromBuffer(const char* paramBuffer,const unsigned char* binBuffer, const InferOption &opt);
-        cv::Mat forward(const cv::Mat& input); // input u8c3, output u8c3
+        cv::Mat forward(const cv::Mat& input, ExecContext* ctx = nullptr); // input u8c3, output u8c3
     private:
+        MappedFile weights; // outlives model
         ncnn::Net model;
 
         const float norm_vals[3] = {1 / 255.f, 1 / 255.f, 1 / 255.f};
     };
 
+    class ThreadPool;
+
+    class DBPostProcess {
+    public:
+        DBPostProcess() = default;
+        ~DBPostProcess() = default;
+
+        // pred pixel (x, y) is mapped to ((x + 0.5) * scale_x - 0.5 + offset_x, (y + 0.5) * scale_y - 0.5 + offset_y),
+        // bounds of candidates dropped for being tiny or low score go to rejected when given.
+        // a stopped request (ctx->request) skips the contours left, boxes fitted so far are kept.
+        // the intermediate maps are the scratch buffers of ctx when given
+        std::vector<TextBox> process(const cv::Mat& pred, float scale_x = 1.f, float scale_y = 1.f, float offset_x = 0.f, float offset_y = 0.f,
+                                     std::vector<cv::Rect2f>* rejected = nullptr, ThreadPool* pool = nullptr, ExecContext* ctx = nullptr) const;
+
+        // horizontal text ends with angle 60 ~ 150, vertical text with -30 ~ 60,
+        // width is always the text height side, return true for vertical text
+        static bool normalizeBox(cv::RotatedRect& box);
+        static TextBox toTextBox(const cv::RotatedRect& box, bool vertical, float score);
+
+        float threshold = 0.3f;
+        float box_threshold = 0.6f;
+        int max_candidates = 1000;
+        float unclip_ratio = 1.95f;
+        int downscale = 1; // 2 or 4 runs thresholding, contours and scoring on a smaller map
+    };
+
     class CTCDecoder {
     public:
         CTCDecoder() = default;
         ~CTCDecoder() = default;
 
         static std::vector<std::tuple<int, float, int>> decode(const cv::Mat& probs, int blank_index = 0); // return token, prob, index
+        // first index of the largest value in row, vectorized with runtime dispatch
+        static int argmax(const float* row, int n, float& max_value);
     };
 } // namespace LiteOCR
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+
+namespace LiteOCR {
+
+    // fixed capacity queue between two pipeline stages, a full queue blocks the producer
+    template <typename T>
+    class BoundedQueue {
+    public:
+        explicit BoundedQueue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) {}
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+        // false once the queue is closed, the item is dropped then
+        bool push(T item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_full.wait(lock, [this]() { return closed || items.size() < capacity; });
+            if (closed) return false;
+            items.push_back(std::move(item));
+            lock.unlock();
+            not_empty.notify_one();
+            return true;
+        }
+
+        // false once the queue is closed and drained
+        bool pop(T& item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            not_empty.wait(lock, [this]() { return closed || !items.empty(); });
+            if (items.empty()) return false;
+            item = std::move(items.front());
+            items.pop_front();
+            lock.unlock();
+            not_full.notify_one();
+            return true;
+        }
+
+        // items already queued can still be popped
+        void close() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                closed = true;
+            }
+            not_full.notify_all();
+            not_empty.notify_all();
+        }
+
+        size_t size() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return items.size();
+        }
+
+    private:
+        const size_t capacity;
+        std::deque<T> items;
+        std::mutex mutex;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+        bool closed = false;
+    };
+
+} // namespace LiteOCR
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LiteOCR {
+
+    // layout of a model bundle, in host byte order:
+    //   BundleHeader, BundleEntry[count], entry data each starting on a BUNDLE_ALIGN boundary.
+    // param entries keep a trailing NUL so ncnn parses them in place. vocab entries hold a uint32
+    // token count, count + 1 uint32 offsets into the token bytes, then the token bytes.
+    // entry names: det.param det.bin rec.param rec.bin rec.vocab ori.param ori.bin
+    //              table_cnn.param table_cnn.bin table_head.param table_head.bin table.vocab
+    constexpr char BUNDLE_MAGIC[8] = {'L', 'O', 'C', 'R', 'B', 'N', 'D', 'L'};
+    constexpr uint32_t BUNDLE_VERSION = 1;
+    constexpr size_t BUNDLE_ALIGN = 64;
+
+    struct BundleHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t count;
+    };
+
+    struct BundleEntry {
+        char name[32]; // NUL padded
+        uint64_t offset; // from the start of the file
+        uint64_t size;
+    };
+
+    // a bundle mapped in one piece, entry data points into the mapping and lives as long as it
+    class ModelBundle {
+    public:
+        // drops any previous bundle first, false if the file is not a valid bundle
+        bool open(const char* path);
+
+        // null if the bundle has no such entry
+        const unsigned char* data(const char* name) const;
+        // bytes of the entry, 0 if missing
+        size_t size(const char* name) const;
+        // NUL terminated param text, null if missing
+        const char* param(const char* name) const;
+        // tokens as views into the mapping, valid while the bundle stays open. false if missing
+        bool vocab(const char* name, std::vector<std::string_view>& tokens) const;
+
+    private:
+        const BundleEntry* find(const char* name) const;
+
+        MappedFile file;
+        const BundleEntry* entries = nullptr;
+        uint32_t count = 0;
+    };
+
+} // namespace LiteOCR
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstdint>
+
+namespace LiteOCR {
+
+    // heap allocations charged to one request
+    struct AllocationCounter {
+        std::atomic<uint64_t> mat{0};
+        std::atomic<uint64_t> blob{0};
+    };
+
+    // charges the allocations of this thread to counter until the scope ends, scopes nest
+    class AllocationScope {
+    public:
+        explicit AllocationScope(AllocationCounter* counter) : previous(active) { active = counter; }
+        ~AllocationScope() { active = previous; }
+
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+
+        // counter of the calling thread, null outside any scope
+        static AllocationCounter* current() { return active; }
+
+    private:
+        AllocationCounter* previous;
+        static inline thread_local AllocationCounter* active = nullptr;
+    };
+
+    // cv::Mat::setDefaultAllocator wrapper around the standard allocator, counts every buffer
+    // OpenCV allocates for a thread inside an AllocationScope. it stays installed once set
+    void install_counting_mat_allocator();
+
+} // namespace LiteOCR
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "LiteOCREngine.h"
+#include "BaseInfer.h"
 
 #include <ncnn/net.h>
 #include <opencv2/core.hpp>
@@ -27,8 +27,18 @@ namespace LiteOCR {
                                  const char* slaheadParamBuffer, const unsigned char* slaheadBinBuffer,
                                  const char* vocabBuffer,
                                  const InferOption &opt);
-        std::vector<std::pair<std::string,std::array<float,8>>> forward(const cv::Mat& input);
+        // vocab already split into tokens
+        bool loadModelFromBuffer(const char* cnnParamBuffer, const unsigned char* cnnBinBuffer,
+                                 const char* slaheadParamBuffer, const unsigned char* slaheadBinBuffer,
+                                 std::vector<std::string> tokens,
+                                 const InferOption &opt);
+        // a stopped request ends the decoder early with the cells found so far
+        std::vector<std::pair<std::string,std::array<float,8>>> forward(const cv::Mat& input, ExecContext* ctx = nullptr);
+        // side length both image sides are resized to
+        int inputSize() const { return target_size; }
     private:
+        MappedFile cnnWeights; // declared first, the nets read from them until destroyed
+        MappedFile slaheadWeights;
         ncnn::Net cnnModel;
         ncnn::Net slaheadModel;
         std::vector<std::string> vocab;
@@ -1,6 +1,11 @@
 #include "LiteOCREngine.h"
 #include "BaseInfer.h"
+#include "Bundle.h"
 #include "DocInfer.h"
+#include "RecognizerRegistry.h"
+#include "BoundedQueue.h"
+#include "Scheduler.h"
+#include "ThreadPool.h"
 
 #include "opencv2/core/mat.hpp"
 #include "opencv2/core/types.hpp"
@@ -8,333 +13,980 @@
 
 #include <opencv2/opencv.hpp>
 #include <ncnn/net.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <fstream>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <numeric>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <vector>
 
 namespace LiteOCR {
 
-static float contour_score(const cv::Mat& binary, const std::vector<cv::Point>& contour)
+static cv::RotatedRect to_rotated_rect(const TextBox& textBox)
 {
-    cv::Rect rect = cv::boundingRect(contour);
-    if (rect.x < 0)
-        rect.x = 0;
-    if (rect.y < 0)
-        rect.y = 0;
-    if (rect.x + rect.width > binary.cols)
-        rect.width = binary.cols - rect.x;
-    if (rect.y + rect.height > binary.rows)
-        rect.height = binary.rows - rect.y;
+    return cv::RotatedRect(
+        cv::Point2f(textBox.box.center.x, textBox.box.center.y),
+        cv::Size2f(textBox.box.size.width, textBox.box.size.height),
+        textBox.box.angle
+    );
+}
 
-    cv::Mat binROI = binary(rect);
+static std::vector<int> tile_starts(int length, int tile, int step)
+{
+    std::vector<int> starts;
+    for (int x = 0; ; x += step) {
+        int start = std::min(x, std::max(0, length - tile));
+        starts.push_back(start);
+        if (start + tile >= length) break;
+    }
+    return starts;
+}
 
-    cv::Mat mask = cv::Mat::zeros(rect.height, rect.width, CV_8U);
-    std::vector<cv::Point> roiContour;
-    for (size_t i = 0; i < contour.size(); i++)
-    {
-        cv::Point pt = cv::Point(contour[i].x - rect.x, contour[i].y - rect.y);
-        roiContour.push_back(pt);
+static float intersection_area(const cv::RotatedRect& a, const cv::RotatedRect& b)
+{
+    std::vector<cv::Point2f> region;
+    if (cv::rotatedRectangleIntersection(a, b, region) == cv::INTERSECT_NONE || region.size() < 3) {
+        return 0.f;
     }
+    std::vector<cv::Point2f> hull;
+    cv::convexHull(region, hull);
+    return static_cast<float>(cv::contourArea(hull));
+}
 
-    std::vector<std::vector<cv::Point> > roiContours = {roiContour};
-    cv::fillPoly(mask, roiContours, cv::Scalar(1.0f));
+// boxes reaching over a tile edge which is not an image edge may be cut by the seam
+static bool crosses_inner_edge(const TextBox& textBox, const cv::Rect& tile, const cv::Size& image)
+{
+    cv::Rect2f bound = to_rotated_rect(textBox).boundingRect2f();
+    return (tile.x > 0 && bound.x < tile.x)
+        || (tile.y > 0 && bound.y < tile.y)
+        || (tile.x + tile.width < image.width && bound.x + bound.width > tile.x + tile.width)
+        || (tile.y + tile.height < image.height && bound.y + bound.height > tile.y + tile.height);
+}
 
-    float score = cv::mean(binROI, mask).val[0];
-    return score;
+// grow overlapping rects into their union until all rects are disjoint
+static std::vector<cv::Rect> merge_regions(std::vector<cv::Rect> regions)
+{
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < regions.size() && !merged; i++) {
+            for (size_t j = i + 1; j < regions.size(); j++) {
+                if ((regions[i] & regions[j]).area() > 0) {
+                    regions[i] |= regions[j];
+                    regions.erase(regions.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+    return regions;
 }
 
-class LiteOCREngineImpl {
-private:
+struct TiledBox {
+    TextBox textBox;
+    int tile;
+    bool cut;
+};
+
+// boxes from different tiles which mostly overlap are the same text seen twice,
+// boxes cut by a seam which overlap a little are pieces of one line
+static std::vector<TextBox> merge_tiled_boxes(const std::vector<TiledBox>& boxes)
+{
+    int n = static_cast<int>(boxes.size());
+    std::vector<cv::RotatedRect> rects(n);
+    std::vector<cv::Rect2f> bounds(n);
+    std::vector<float> areas(n);
+    for (int i = 0; i < n; i++) {
+        rects[i] = to_rotated_rect(boxes[i].textBox);
+        bounds[i] = rects[i].boundingRect2f();
+        areas[i] = rects[i].size.width * rects[i].size.height;
+    }
+
+    std::vector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](int i) {
+        while (parent[i] != i) {
+            i = parent[i] = parent[parent[i]];
+        }
+        return i;
+    };
+
+    // sweep along x, only boxes with overlapping x ranges are compared
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&bounds](int a, int b) { return bounds[a].x < bounds[b].x; });
+
+    for (int oi = 0; oi < n; oi++) {
+        int i = order[oi];
+        for (int oj = oi + 1; oj < n && bounds[order[oj]].x <= bounds[i].x + bounds[i].width; oj++) {
+            int j = order[oj];
+            if (boxes[i].tile == boxes[j].tile) continue;
+            if ((bounds[i] & bounds[j]).area() <= 0.f) continue;
+
+            float io_min = intersection_area(rects[i], rects[j]) / std::max(1.f, std::min(areas[i], areas[j]));
+            bool same = io_min > 0.5f;
+            bool pieces = boxes[i].cut && boxes[j].cut && io_min > 0.1f
+                && boxes[i].textBox.isVertical == boxes[j].textBox.isVertical
+                && std::abs(rects[i].angle - rects[j].angle) < 10.f;
+            if (same || pieces) {
+                parent[find(i)] = find(j);
+            }
+        }
+    }
+
+    std::vector<std::vector<int>> groups(n);
+    for (int i = 0; i < n; i++) {
+        groups[find(i)].push_back(i);
+    }
+
+    std::vector<TextBox> textBoxes;
+    for (int i = 0; i < n; i++) {
+        if (groups[i].empty()) continue;
+        const auto &group = groups[i];
+        if (group.size() == 1) {
+            textBoxes.push_back(boxes[group[0]].textBox);
+            continue;
+        }
+
+        // a tile which saw the whole line wins, otherwise join the pieces
+        int best = -1;
+        for (int k : group) {
+            if (!boxes[k].cut && (best == -1 || areas[k] > areas[best])) {
+                best = k;
+            }
+        }
+        if (best != -1) {
+            textBoxes.push_back(boxes[best].textBox);
+            continue;
+        }
+
+        std::vector<cv::Point2f> points;
+        float score = 0.f;
+        for (int k : group) {
+            cv::Point2f corners[4];
+            rects[k].points(corners);
+            points.insert(points.end(), corners, corners + 4);
+            score = std::max(score, boxes[k].textBox.score);
+        }
+        cv::RotatedRect box = cv::minAreaRect(points);
+        bool vertical = DBPostProcess::normalizeBox(box);
+        textBoxes.push_back(DBPostProcess::toTextBox(box, vertical, score));
+    }
+    return textBoxes;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// stage of stats by name, added in first use order
+static StartupStats::Stage &startup_stage(StartupStats &stats, const char *name)
+{
+    for (auto &stage : stats.stages) {
+        if (stage.name == name) {
+            return stage;
+        }
+    }
+    stats.stages.push_back(StartupStats::Stage{name});
+    return stats.stages.back();
+}
+
+// white image with dark strokes in rows like printed text, the detector finds boxes on it and
+// the recognizer decodes something, so warm-up goes through the same paths as real input
+static cv::Mat synthetic_text(int width, int height, int line_height)
+{
+    cv::Mat image(height, width, CV_8UC3, cv::Scalar(255, 255, 255));
+    int stroke = std::max(1, line_height / 8);
+    for (int y = line_height / 4; y + line_height <= height; y += line_height * 2) {
+        for (int x = line_height / 4; x + line_height / 2 <= width; x += line_height * 3 / 4) {
+            image(cv::Rect(x, y, stroke, line_height)).setTo(cv::Scalar(0, 0, 0));
+            image(cv::Rect(x, y + line_height - stroke, line_height / 2, stroke)).setTo(cv::Scalar(0, 0, 0));
+        }
+    }
+    return image;
+}
+
+// the models of one load. a request takes a reference when it starts and reads with the same
+// models to the end, a reload swaps in a new set and the old one goes with its last request
+struct ModelSet {
+    LiteOCR::ModelBundle bundle; // weights of a loadBundle set, outlives the models
     std::unique_ptr<LiteOCR::BaseDetector> detector;
-    std::unique_ptr<LiteOCR::BaseRecognizer> recognizer;
+    // recognizer and vocab read with when a request names no language
+    std::shared_ptr<LiteOCR::RecognizerModel> recognizer;
     std::unique_ptr<LiteOCR::BaseClassifier> textlineORI;
+};
 
-    std::vector<std::string> vocab;
-
-    const float threshold = 0.3f;
-    const float box_threshold = 0.6f;
-    const int max_candidates = 1000;
-    const float unclip_ratio = 1.95f;
+class LiteOCREngineImpl {
+private:
+    // replaced whole on reload, requests only copy the pointer
+    std::atomic<std::shared_ptr<const ModelSet>> models;
+    LiteOCR::InferOption load_opt; // reloads load with the options of the first load
+    std::mutex reload_mutex; // one reload or warm-up at a time
+    LiteOCR::RecognizerRegistry recognizers;
+    // runs async requests, and helps the lanes of any request when numWorkers > 1
+    std::unique_ptr<LiteOCR::ThreadPool> pool;
+    int num_workers = 1;
+    LiteOCR::ExecContextPool contexts;
+    LiteOCR::Scheduler scheduler;
+
+    LiteOCR::DBPostProcess postprocess;
     const int target_height = 48;
 
+    int rec_batch_size = 8;
+    int rec_bucket_width = 32;
+    int det_limit_side_len = 0;
+    int det_max_pixels = 0;
+    int det_tile_size = 0;
+    int det_tile_overlap = 128;
+    float det_coarse_scale = 0.f;
+    float det_fine_min_height = 16.f;
+    float det_fine_score = 0.7f;
+    float ori_min_aspect = 0.f;
+
+    mutable std::mutex startup_mutex;
+    LiteOCR::StartupStats startup;
+    LiteOCR::WarmupOption warmup_opt; // a reload warms the new set the same way
+
 public:
     LiteOCREngineImpl() {
         
     }
 
+    ~LiteOCREngineImpl() {
+        // finish queued async requests while the models are still alive
+        pool.reset();
+    }
+
+    // pool for the parallel paths inside one request, none when they run on the caller only
+    LiteOCR::ThreadPool* lane_pool() const {
+        return num_workers > 1 ? pool.get() : nullptr;
+    }
+
+    // run fn on the engine's pool, requests queue up behind each other and share the workers
+    void submit(std::function<void()> fn) {
+        pool->submit(std::move(fn));
+    }
+
+    void configure(const LiteOCR::InferOption &opt) {
+        load_opt = opt;
+        rec_batch_size = std::max(1, opt.recBatchSize);
+        rec_bucket_width = std::max(1, opt.recBucketWidth);
+        det_limit_side_len = opt.detLimitSideLen;
+        det_max_pixels = opt.detMaxPixels;
+        det_tile_size = opt.detTileSize;
+        det_tile_overlap = std::max(0, opt.detTileOverlap);
+        det_coarse_scale = opt.detCoarseScale;
+        postprocess.downscale = std::max(1, opt.detPostScale);
+        det_fine_min_height = opt.detFineMinHeight;
+        det_fine_score = opt.detFineScore;
+        ori_min_aspect = opt.oriMinAspect;
+        scheduler.setSlots(opt.schedulerSlots);
+        contexts.configure(static_cast<size_t>(std::max(0, opt.poolCapMB)) << 20);
+        recognizers.configure(opt, static_cast<size_t>(std::max(0, opt.recognizerBudgetMB)) << 20);
+        if (opt.countAllocations) {
+            install_counting_mat_allocator();
+        }
+        num_workers = std::max(1, opt.numWorkers);
+        pool.reset(new LiteOCR::ThreadPool(std::max(1, num_workers - 1)));
+    }
+
+    int recBatchSize() const { return rec_batch_size; }
+
+    // for threads outside the request paths, such as the stream stages
+    ExecContextPool::Lease leaseContext() { return contexts.acquire(); }
+
     bool loadModel(const char* detParamPath, const char* detBinPath,
                    const char* recParamPath, const char* recBinPath,
                    const char* vocabPath,
                    const char* oriParamPath,
                    const char* oriBinPath,
                    const LiteOCR::InferOption &opt) {
-        detector = std::unique_ptr<LiteOCR::BaseDetector>(new LiteOCR::PaddleDetector());
-        recognizer = std::unique_ptr<LiteOCR::BaseRecognizer>(new LiteOCR::PaddleRecognizer());
+        configure(opt);
+        auto set = std::make_shared<ModelSet>();
+        LiteOCR::StartupStats stats;
+        if (!load_files(*set, stats, detParamPath, detBinPath, recParamPath, recBinPath, vocabPath, oriParamPath, oriBinPath, opt)) {
+            return false;
+        }
+        install(std::move(set), stats);
+        return true;
+    }
+
+    bool loadModelFromBuffer(const char* detParamBuffer, const unsigned char* detBinBuffer,
+                             const char* recParamBuffer, const unsigned char* recBinBuffer,
+                             const char* vocabBuffer,
+                             const char* oriParamBuffer,
+                             const unsigned char* oriBinBuffer,
+                             const LiteOCR::InferOption &opt) {
+        configure(opt);
+        auto set = std::make_shared<ModelSet>();
+        LiteOCR::StartupStats stats;
+        if (!load_buffers(*set, stats, detParamBuffer, detBinBuffer, recParamBuffer, recBinBuffer, oriParamBuffer, oriBinBuffer, opt)) {
+            return false;
+        }
+        // load vocab from buffer
+        auto start = std::chrono::steady_clock::now();
+        LiteOCR::set_vocab(*set->recognizer, vocabBuffer);
+        startup_stage(stats, "vocab").loadMs = elapsed_ms(start);
+        install(std::move(set), stats);
+        return true;
+    }
+
+    bool loadBundle(const char* bundlePath, const LiteOCR::InferOption &opt) {
+        configure(opt);
+        auto set = std::make_shared<ModelSet>();
+        LiteOCR::StartupStats stats;
+        if (!load_bundle(*set, stats, bundlePath, opt)) {
+            return false;
+        }
+        install(std::move(set), stats);
+        return true;
+    }
 
-        bool ret = detector->loadModel(detParamPath, detBinPath, opt);
+    // a new set is loaded with the options of the first load while requests keep running on the
+    // current one, warmed when the current one was, then swapped in
+    bool reloadModel(const char* detParamPath, const char* detBinPath,
+                     const char* recParamPath, const char* recBinPath,
+                     const char* vocabPath,
+                     const char* oriParamPath,
+                     const char* oriBinPath) {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        auto set = std::make_shared<ModelSet>();
+        LiteOCR::StartupStats stats;
+        if (!load_files(*set, stats, detParamPath, detBinPath, recParamPath, recBinPath, vocabPath, oriParamPath, oriBinPath, load_opt)) {
+            return false;
+        }
+        swap_in(std::move(set), stats);
+        return true;
+    }
+
+    bool reloadBundle(const char* bundlePath) {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        auto set = std::make_shared<ModelSet>();
+        LiteOCR::StartupStats stats;
+        if (!load_bundle(*set, stats, bundlePath, load_opt)) {
+            return false;
+        }
+        swap_in(std::move(set), stats);
+        return true;
+    }
+
+    // the set requests start with from now on
+    std::shared_ptr<const ModelSet> current() const
+    {
+        return models.load();
+    }
+
+    // the lanes of one request lease up to num_workers contexts, each of them is warmed with its
+    // own allocator pools and scratch buffers
+    LiteOCR::StartupStats warmup(const LiteOCR::WarmupOption &opt)
+    {
+        std::lock_guard<std::mutex> lock(reload_mutex);
+        LiteOCR::StartupStats stats = startupStats();
+        warm(*current(), opt, stats);
+        std::lock_guard<std::mutex> stats_lock(startup_mutex);
+        startup = stats;
+        warmup_opt = opt;
+        return startup;
+    }
+
+    LiteOCR::StartupStats startupStats() const
+    {
+        std::lock_guard<std::mutex> lock(startup_mutex);
+        return startup;
+    }
+
+    void install(std::shared_ptr<const ModelSet> set, const LiteOCR::StartupStats &stats)
+    {
+        models.store(std::move(set));
+        std::lock_guard<std::mutex> lock(startup_mutex);
+        startup = stats;
+    }
+
+    void swap_in(std::shared_ptr<ModelSet> set, LiteOCR::StartupStats &stats)
+    {
+        if (startupStats().warm) {
+            warm(*set, warmup_opt, stats);
+        }
+        // requests holding the old set finish on it, the last one frees it
+        install(std::move(set), stats);
+    }
+
+    bool load_files(ModelSet &set, LiteOCR::StartupStats &stats,
+                    const char* detParamPath, const char* detBinPath,
+                    const char* recParamPath, const char* recBinPath,
+                    const char* vocabPath,
+                    const char* oriParamPath,
+                    const char* oriBinPath,
+                    const LiteOCR::InferOption &opt) {
+        set.detector = std::unique_ptr<LiteOCR::BaseDetector>(new LiteOCR::PaddleDetector());
+        set.recognizer = std::make_shared<LiteOCR::RecognizerModel>();
+        set.recognizer->recognizer = std::unique_ptr<LiteOCR::BaseRecognizer>(new LiteOCR::PaddleRecognizer());
+
+        auto start = std::chrono::steady_clock::now();
+        bool ret = set.detector->loadModel(detParamPath, detBinPath, opt);
         if (!ret) {
             fprintf(stderr, "[LiteOCR]Failed to load detector model from %s and %s\n", detParamPath, detBinPath);
-            detector.reset();
-            recognizer.reset();
             return false;
         }
-        ret = recognizer->loadModel(recParamPath, recBinPath, opt);
+        startup_stage(stats, "detector").loadMs = elapsed_ms(start);
+        start = std::chrono::steady_clock::now();
+        ret = set.recognizer->recognizer->loadModel(recParamPath, recBinPath, opt);
         if (!ret) {
             fprintf(stderr, "[LiteOCR]Failed to load recognizer model from %s and %s\n", recParamPath, recBinPath);
-            detector.reset();
-            recognizer.reset();
             return false;
         }
+        startup_stage(stats, "recognizer").loadMs = elapsed_ms(start);
         if (oriParamPath && oriBinPath) {
-            textlineORI = std::unique_ptr<LiteOCR::BaseClassifier>(new LiteOCR::PaddleTextlineORI());
-            ret = textlineORI->loadModel(oriParamPath, oriBinPath, opt);
+            start = std::chrono::steady_clock::now();
+            set.textlineORI = std::unique_ptr<LiteOCR::BaseClassifier>(new LiteOCR::PaddleTextlineORI());
+            ret = set.textlineORI->loadModel(oriParamPath, oriBinPath, opt);
             if (!ret) {
                 fprintf(stderr, "[LiteOCR]Failed to load textline orientation model from %s and %s\n", oriParamPath, oriBinPath);
-                detector.reset();
-                recognizer.reset();
-                textlineORI.reset();
                 return false;
             }
+            startup_stage(stats, "orientation").loadMs = elapsed_ms(start);
         }
         // load vocab
-        vocab.clear();
-        std::ifstream vocabFile(vocabPath);
-        if (!vocabFile.is_open()) {
-            fprintf(stderr, "[LiteOCR]Failed to open vocab file from %s\n", vocabPath);
-            detector.reset();
-            recognizer.reset();
-            textlineORI.reset();
+        start = std::chrono::steady_clock::now();
+        if (!LiteOCR::read_vocab(*set.recognizer, vocabPath)) {
             return false;
         }
-        std::string line;
-        while (std::getline(vocabFile, line)) {
-            vocab.push_back(line);
-        }
-        vocabFile.close();
+        startup_stage(stats, "vocab").loadMs = elapsed_ms(start);
         return true;
     }
 
-    bool loadModelFromBuffer(const char* detParamBuffer, const unsigned char* detBinBuffer,
-                             const char* recParamBuffer, const unsigned char* recBinBuffer,
-                             const char* vocabBuffer,
-                             const char* oriParamBuffer,
-                             const unsigned char* oriBinBuffer,
-                             const LiteOCR::InferOption &opt) {
-        bool ret = detector->loadModelFromBuffer(detParamBuffer, detBinBuffer, opt);
-        if (!ret) return false;
-        ret = recognizer->loadModelFromBuffer(recParamBuffer, recBinBuffer, opt);
-        if (!ret) return false;
+    // models only, the caller sets the recognizer vocab
+    bool load_buffers(ModelSet &set, LiteOCR::StartupStats &stats,
+                      const char* detParamBuffer, const unsigned char* detBinBuffer,
+                      const char* recParamBuffer, const unsigned char* recBinBuffer,
+                      const char* oriParamBuffer,
+                      const unsigned char* oriBinBuffer,
+                      const LiteOCR::InferOption &opt) {
+        set.detector = std::unique_ptr<LiteOCR::BaseDetector>(new LiteOCR::PaddleDetector());
+        set.recognizer = std::make_shared<LiteOCR::RecognizerModel>();
+        set.recognizer->recognizer = std::unique_ptr<LiteOCR::BaseRecognizer>(new LiteOCR::PaddleRecognizer());
+
+        auto start = std::chrono::steady_clock::now();
+        bool ret = set.detector->loadModelFromBuffer(detParamBuffer, detBinBuffer, opt);
+        if (!ret) {
+            fprintf(stderr, "[LiteOCR]Failed to load detector model from buffer\n");
+            return false;
+        }
+        startup_stage(stats, "detector").loadMs = elapsed_ms(start);
+        start = std::chrono::steady_clock::now();
+        ret = set.recognizer->recognizer->loadModelFromBuffer(recParamBuffer, recBinBuffer, opt);
+        if (!ret) {
+            fprintf(stderr, "[LiteOCR]Failed to load recognizer model from buffer\n");
+            return false;
+        }
+        startup_stage(stats, "recognizer").loadMs = elapsed_ms(start);
         if (oriParamBuffer && oriBinBuffer) {
-            ret = textlineORI->loadModelFromBuffer(oriParamBuffer, oriBinBuffer, opt);
-            if (!ret) return false;
+            start = std::chrono::steady_clock::now();
+            set.textlineORI = std::unique_ptr<LiteOCR::BaseClassifier>(new LiteOCR::PaddleTextlineORI());
+            ret = set.textlineORI->loadModelFromBuffer(oriParamBuffer, oriBinBuffer, opt);
+            if (!ret) {
+                fprintf(stderr, "[LiteOCR]Failed to load textline orientation model from buffer\n");
+                return false;
+            }
+            startup_stage(stats, "orientation").loadMs = elapsed_ms(start);
         }
-        // load vocab from buffer
-        vocab.clear();
-        std::istringstream vocabStream(vocabBuffer);
-        std::string line;
-        while (std::getline(vocabStream, line)) {
-            vocab.push_back(line);
+        return true;
+    }
+
+    bool load_bundle(ModelSet &set, LiteOCR::StartupStats &stats, const char* bundlePath, const LiteOCR::InferOption &opt) {
+        auto start = std::chrono::steady_clock::now();
+        if (!set.bundle.open(bundlePath)) {
+            fprintf(stderr, "[LiteOCR]Failed to open model bundle %s\n", bundlePath);
+            return false;
+        }
+        const char* detParam = set.bundle.param("det.param");
+        const unsigned char* detBin = set.bundle.data("det.bin");
+        const char* recParam = set.bundle.param("rec.param");
+        const unsigned char* recBin = set.bundle.data("rec.bin");
+        std::vector<std::string_view> tokens;
+        if (!detParam || !detBin || !recParam || !recBin || !set.bundle.vocab("rec.vocab", tokens)) {
+            fprintf(stderr, "[LiteOCR]Model bundle %s has no detector, recognizer and vocab\n", bundlePath);
+            return false;
+        }
+        // mapping, index and vocab table, the models and the vocab read their entries in place
+        startup_stage(stats, "bundle").loadMs = elapsed_ms(start);
+        if (!load_buffers(set, stats, detParam, detBin, recParam, recBin,
+                          set.bundle.param("ori.param"), set.bundle.data("ori.bin"), opt)) {
+            return false;
         }
+        set.recognizer->vocab = std::move(tokens);
         return true;
     }
 
-    std::vector<TextBox> detect(const cv::Mat &input)
+    void warm(const ModelSet &set, const LiteOCR::WarmupOption &opt, LiteOCR::StartupStats &stats)
     {
-        auto pred = detector->forward(input);
-        cv::Mat binary;
-        cv::threshold(pred, binary, threshold, 1, cv::THRESH_BINARY);
-        binary.convertTo(binary, CV_8U, 255);
-
-        std::vector<std::vector<cv::Point>> contours;
-        cv::findContours(binary, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+        std::vector<ExecContextPool::Lease> leases;
+        leases.reserve(num_workers);
+        for (int i = 0; i < num_workers; i++) {
+            leases.push_back(contexts.acquire());
+        }
 
-        contours.resize(std::min(contours.size(), (size_t)max_candidates));
+        auto start = std::chrono::steady_clock::now();
+        for (int side : opt.detectorSides) {
+            if (side <= 0) {
+                continue;
+            }
+            cv::Mat page = synthetic_text(side * 3 / 4, side, std::max(16, side / 40));
+            for (auto &ctx : leases) {
+                ctx->numThreads = 0;
+                detect(set, page, PixelFormat::BGR, ctx.get());
+            }
+        }
+        startup_stage(stats, "detector").warmupMs = elapsed_ms(start);
 
+        // one line per bucket width, the input widths recognition sees
+        std::vector<cv::Mat> lines;
         std::vector<TextBox> textBoxes;
+        int max_width = std::max(rec_bucket_width, opt.recognizerMaxWidth);
+        for (int width = rec_bucket_width; width <= max_width; width += rec_bucket_width) {
+            lines.push_back(synthetic_text(width, target_height, target_height * 2 / 3));
+            TextBox textBox{};
+            textBox.box.center = {width * 0.5f, target_height * 0.5f};
+            textBox.box.size = {static_cast<float>(width), static_cast<float>(target_height)};
+            textBoxes.push_back(textBox);
+        }
+        std::vector<std::vector<TextlineCrop>> batches;
+        for (size_t i = 0; i < lines.size(); i++) {
+            batches.emplace_back(rec_batch_size, crop(lines[i], PixelFormat::BGR, textBoxes[i]));
+        }
 
-        for (const auto& contour : contours) {
-            if (contour.size() < 4) continue;
-
-            float score = contour_score(pred, contour);
-            if (score < box_threshold) continue;
-
-            cv::RotatedRect box = cv::minAreaRect(contour);
-
-            int orientation = 0;
-
-            if (box.angle >= -30 && box.angle <= 30 && box.size.height > box.size.width * 2.7)
-            {
-                // vertical text
-                orientation = 1;
-            }
-            if ((box.angle <= -60 || box.angle >= 60) && box.size.width > box.size.height * 2.7)
-            {
-                // vertical text
-                orientation = 1;
-            }
-
-            if (box.angle < -30)
-            {
-                // make orientation from -90 ~ -30 to 90 ~ 150
-                box.angle += 180;
-            }
-            if (orientation == 0 && box.angle < 30)
-            {
-                // make it horizontal
-                box.angle += 90;
-                std::swap(box.size.width, box.size.height);
-            }
-            if (orientation == 1 && box.angle >= 60)
-            {
-                // make it vertical
-                box.angle -= 90;
-                std::swap(box.size.width, box.size.height);
-            }
-
-           // enlarge
-            box.size.height += box.size.width * (unclip_ratio - 1);
-            box.size.width *= unclip_ratio;
-            
-            textBoxes.push_back(TextBox{
-                .box = TextBox::RotatedRect{
-                    .center = TextBox::RotatedRect::Point{box.center.x, box.center.y},
-                    .size = TextBox::RotatedRect::Size{box.size.width, box.size.height},
-                    .angle = box.angle
-                },
-                .isVertical = (orientation == 1),
-                .score = score
-            });
+        start = std::chrono::steady_clock::now();
+        for (auto &ctx : leases) {
+            ctx->numThreads = num_workers > 1 ? 1 : 0;
+            for (const auto &batch : batches) {
+                read(batch, *set.recognizer, *ctx);
+            }
         }
+        startup_stage(stats, "recognizer").warmupMs = elapsed_ms(start);
 
-        return textBoxes;
+        if (set.textlineORI && !batches.empty()) {
+            start = std::chrono::steady_clock::now();
+            for (auto &ctx : leases) {
+                set.textlineORI->forwardCrops(batches.back(), ctx.get());
+            }
+            startup_stage(stats, "orientation").warmupMs = elapsed_ms(start);
+        }
+        stats.warm = true;
     }
 
-    std::vector<Textline> recognize(const cv::Mat &input, std::vector<TextBox> &textBoxes)
+    // without ctx the call leases its own execution context
+    std::vector<TextBox> detect(const ModelSet &set, const cv::Mat &input, PixelFormat format, ExecContext *ctx = nullptr)
     {
-        std::vector<Textline> results;
-        std::vector<cv::Mat> rois;
+        if (det_coarse_scale > 0.f && det_coarse_scale < 1.f) {
+            return detect_coarse_to_fine(set, input, format, ctx);
+        }
+        return detect_full(set, input, format, ctx);
+    }
 
-        for (const auto &textBox : textBoxes) {
-            cv::Point2f corners[4];
-            cv::RotatedRect(
-                cv::Point2f(textBox.box.center.x, textBox.box.center.y),
-                cv::Size2f(textBox.box.size.width, textBox.box.size.height),
-                textBox.box.angle
-            ).points(corners);
-
-            int target_width = static_cast<int>(textBox.box.size.height * target_height / textBox.box.size.width);
-
-            cv::Mat dst;
-
-            if (!textBox.isVertical)
-            {
-                // horizontal text
-                // corner points order
-                //  0--------1
-                //  |        |rw  -> as angle=90
-                //  3--------2
-                //      rh
-
-                std::vector<cv::Point2f> src_pts(3);
-                src_pts[0] = corners[0];
-                src_pts[1] = corners[1];
-                src_pts[2] = corners[3];
-
-                std::vector<cv::Point2f> dst_pts(3);
-                dst_pts[0] = cv::Point2f(0, 0);
-                dst_pts[1] = cv::Point2f(target_width, 0);
-                dst_pts[2] = cv::Point2f(0, target_height);
-
-                cv::Mat tm = cv::getAffineTransform(src_pts, dst_pts);
-
-                cv::warpAffine(input, dst, tm, cv::Size(target_width, target_height), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
-            }
-            else
-            {
-                // vertial text
-                // corner points order
-                //  1----2
-                //  |    |
-                //  |    |
-                //  |    |rh  -> as angle=0
-                //  |    |
-                //  |    |
-                //  0----3
-                //    rw
-
-                std::vector<cv::Point2f> src_pts(3);
-                src_pts[0] = corners[2];
-                src_pts[1] = corners[3];
-                src_pts[2] = corners[1];
-
-                std::vector<cv::Point2f> dst_pts(3);
-                dst_pts[0] = cv::Point2f(0, 0);
-                dst_pts[1] = cv::Point2f(target_width, 0);
-                dst_pts[2] = cv::Point2f(0, target_height);
-
-                cv::Mat tm = cv::getAffineTransform(src_pts, dst_pts);
-
-                cv::warpAffine(input, dst, tm, cv::Size(target_width, target_height), cv::INTER_LINEAR, cv::BORDER_REPLICATE);
-            }
-
-            rois.push_back(dst);
-        }
-
-        for (int i = 0; i < rois.size(); i++) {
-            cv::Mat roi = rois[i];
-            if (roi.isContinuous() == false) {
-                roi = roi.clone();
-            }
-
-            if (textlineORI) {
-                int ori_label = textlineORI->forward(roi);
-                if (ori_label == 1) {
-                    // upside down
-                    cv::rotate(roi, roi, cv::ROTATE_180);
-                    textBoxes[i].box.angle += 180.0f;
-                }
+    std::vector<TextBox> detect_full(const ModelSet &set, const cv::Mat &input, PixelFormat format, ExecContext *ctx = nullptr)
+    {
+        if (det_tile_size > 0 && (input.cols > det_tile_size || input.rows > det_tile_size)) {
+            return detect_tiled(set, input, format, ctx ? ctx->request : nullptr);
+        }
+
+        if (!ctx) {
+            auto lease = contexts.acquire();
+            return detect_full(set, input, format, lease.get());
+        }
+        auto pred = set.detector->forward(input, ctx, format);
+        // the detector may run on a downscaled copy, boxes are mapped back to input coordinates
+        return postprocess.process(pred, static_cast<float>(input.cols) / pred.cols, static_cast<float>(input.rows) / pred.rows, 0.f, 0.f, nullptr, lane_pool(), ctx);
+    }
+
+    // detect on overlapping tiles, so peak memory follows the tile size instead of the image size
+    std::vector<TextBox> detect_tiled(const ModelSet &set, const cv::Mat &input, PixelFormat format, RequestState *request = nullptr)
+    {
+        int overlap = std::min(det_tile_overlap, det_tile_size / 2);
+        std::vector<int> xs = tile_starts(input.cols, det_tile_size, det_tile_size - overlap);
+        std::vector<int> ys = tile_starts(input.rows, det_tile_size, det_tile_size - overlap);
+
+        std::vector<cv::Rect> tiles;
+        for (int y : ys) {
+            for (int x : xs) {
+                tiles.push_back(cv::Rect(x, y, std::min(det_tile_size, input.cols - x), std::min(det_tile_size, input.rows - y)));
             }
+        }
 
-            auto textline = recognizer->forward(roi);
-            auto decoded = CTCDecoder::decode(textline);
+        std::vector<std::vector<TiledBox>> tile_boxes(tiles.size());
+        parallel_for(static_cast<int>(tiles.size()), [&](int i, ExecContext &ctx) {
+            if (request && request->stopped()) return;
+            ctx.request = request;
+            const cv::Rect &tile = tiles[i];
+            auto pred = set.detector->forward(input(tile), &ctx, format);
+            auto textBoxes = postprocess.process(pred, static_cast<float>(tile.width) / pred.cols, static_cast<float>(tile.height) / pred.rows, tile.x, tile.y, nullptr, lane_pool(), &ctx);
 
-            std::string text;
-            std::vector<float> anchors;
+            for (const auto &textBox : textBoxes) {
+                tile_boxes[i].push_back(TiledBox{textBox, i, crosses_inner_edge(textBox, tile, input.size())});
+            }
+        });
 
-            for (const auto& [token, prob, index] : decoded) {
-                if (token > 0 && token <= vocab.size()) {
-                    text += vocab[token - 1];
-                    float pos = (index + 0.5f) / textline.cols * roi.cols;
-                    anchors.push_back(pos);
-                } else if (!text.empty() && text.back() != ' ') {
-                    text += ' ';
-                    float pos = (index + 0.5f) / textline.cols * roi.cols;
-                    anchors.push_back(pos);
-                }
+        std::vector<TiledBox> boxes;
+        for (const auto &b : tile_boxes) {
+            boxes.insert(boxes.end(), b.begin(), b.end());
+        }
+        return merge_tiled_boxes(boxes);
+    }
+
+    // detect on a downscaled image first, then only redo small, weak or rejected
+    // candidates at full resolution
+    std::vector<TextBox> detect_coarse_to_fine(const ModelSet &set, const cv::Mat &input, PixelFormat format, ExecContext *ctx = nullptr)
+    {
+        if (!ctx) {
+            auto lease = contexts.acquire();
+            return detect_coarse_to_fine(set, input, format, lease.get());
+        }
+
+        cv::Mat coarse_input;
+        cv::Size coarse_size(std::max(1, static_cast<int>(input.cols * det_coarse_scale + 0.5f)),
+                             std::max(1, static_cast<int>(input.rows * det_coarse_scale + 0.5f)));
+        cv::resize(input, coarse_input, coarse_size, 0, 0, cv::INTER_AREA);
+
+        auto pred = set.detector->forward(coarse_input, ctx, format);
+        std::vector<cv::Rect2f> rejected;
+        RequestState *request = ctx->request;
+        auto coarse = postprocess.process(pred, static_cast<float>(input.cols) / pred.cols, static_cast<float>(input.rows) / pred.rows, 0.f, 0.f, &rejected, lane_pool(), ctx);
+
+        std::vector<TiledBox> boxes;
+        std::vector<cv::Rect2f> uncertain = rejected;
+        for (const auto &textBox : coarse) {
+            // width is the text height side, divide the unclip back out
+            float text_height = textBox.box.size.width / postprocess.unclip_ratio;
+            if (text_height < det_fine_min_height || textBox.score < det_fine_score) {
+                uncertain.push_back(to_rotated_rect(textBox).boundingRect2f());
+            } else {
+                boxes.push_back(TiledBox{textBox, 0, false});
             }
-            results.push_back({text, anchors});
         }
 
-        return results;
+        // pad regions so a line near the region edge is seen whole
+        const float pad = 2.f * det_fine_min_height;
+        cv::Rect image_rect(0, 0, input.cols, input.rows);
+        std::vector<cv::Rect> regions;
+        for (const auto &r : uncertain) {
+            cv::Rect region(static_cast<int>(std::floor(r.x - pad)), static_cast<int>(std::floor(r.y - pad)),
+                            static_cast<int>(std::ceil(r.width + 2 * pad)), static_cast<int>(std::ceil(r.height + 2 * pad)));
+            region &= image_rect;
+            if (region.area() > 0) {
+                regions.push_back(region);
+            }
+        }
+        regions = merge_regions(regions);
+
+        double region_area = 0;
+        for (const auto &region : regions) {
+            region_area += region.area();
+        }
+        if (region_area > 0.5 * image_rect.area()) {
+            // not worth it, most of the page needs the fine pass anyway
+            return detect_full(set, input, format, ctx);
+        }
+
+        std::vector<std::vector<TiledBox>> region_boxes(regions.size());
+        parallel_for(static_cast<int>(regions.size()), [&](int i, ExecContext &ctx) {
+            if (request && request->stopped()) return;
+            ctx.request = request;
+            const cv::Rect &region = regions[i];
+            auto pred = set.detector->forward(input(region), &ctx, format);
+            auto textBoxes = postprocess.process(pred, static_cast<float>(region.width) / pred.cols, static_cast<float>(region.height) / pred.rows, region.x, region.y, nullptr, lane_pool(), &ctx);
+            for (const auto &textBox : textBoxes) {
+                region_boxes[i].push_back(TiledBox{textBox, i + 1, crosses_inner_edge(textBox, region, input.size())});
+            }
+        });
+
+        for (const auto &b : region_boxes) {
+            boxes.insert(boxes.end(), b.begin(), b.end());
+        }
+        return merge_tiled_boxes(boxes);
     }
 
-    std::pair<std::vector<TextBox>, std::vector<Textline>> run(const cv::Mat &input_)
+    static Textline decode(const cv::Mat &textline, int roi_width, const std::vector<std::string_view> &vocab)
     {
-        // must be BGR format
-        if (input_.empty()) {
-            return {{}, {}};
+        auto decoded = CTCDecoder::decode(textline);
+
+        Textline result;
+        std::string &text = result.text;
+
+        for (const auto& [token, prob, index] : decoded) {
+            if (token > 0 && token <= vocab.size()) {
+                text += vocab[token - 1];
+            } else if (!text.empty() && text.back() != ' ') {
+                text += ' ';
+            } else {
+                continue;
+            }
+            float pos = (index + 0.5f) / textline.rows * roi_width;
+            result.anchors.push_back(pos);
+            result.scores.push_back(prob);
+            result.score += prob;
+        }
+        if (!result.scores.empty()) {
+            result.score /= result.scores.size();
         }
+        return result;
+    }
 
-        cv::Mat input;
-        if (input_.channels() == 1) {
-            cv::cvtColor(input_, input, cv::COLOR_GRAY2BGR);
-        } else if (input_.channels() == 4) {
-            cv::cvtColor(input_, input, cv::COLOR_BGRA2BGR);
+    int line_width(const TextBox &textBox) const
+    {
+        return static_cast<int>(textBox.box.size.height * target_height / textBox.box.size.width);
+    }
+
+    // the line is not warped here, the recognizer samples it straight into its input
+    TextlineCrop crop(const cv::Mat &input, PixelFormat format, const TextBox &textBox) const
+    {
+        cv::Point2f corners[4];
+        cv::RotatedRect(
+            cv::Point2f(textBox.box.center.x, textBox.box.center.y),
+            cv::Size2f(textBox.box.size.width, textBox.box.size.height),
+            textBox.box.angle
+        ).points(corners);
+
+        int target_width = std::max(1, line_width(textBox));
+
+        cv::Point2f src_pts[3];
+        if (!textBox.isVertical)
+        {
+            // horizontal text
+            // corner points order
+            //  0--------1
+            //  |        |rw  -> as angle=90
+            //  3--------2
+            //      rh
+
+            src_pts[0] = corners[0];
+            src_pts[1] = corners[1];
+            src_pts[2] = corners[3];
+        }
+        else
+        {
+            // vertial text
+            // corner points order
+            //  1----2
+            //  |    |
+            //  |    |
+            //  |    |rh  -> as angle=0
+            //  |    |
+            //  |    |
+            //  0----3
+            //    rw
+
+            src_pts[0] = corners[2];
+            src_pts[1] = corners[3];
+            src_pts[2] = corners[1];
+        }
+
+        // crop -> image mapping, (0, 0), (target_width, 0) and (0, target_height) go to the
+        // three source points. same as getAffineTransform without its matrix allocation
+        TextlineCrop crop;
+        crop.image = input;
+        crop.format = format;
+        crop.m[0] = (src_pts[1].x - src_pts[0].x) / target_width;
+        crop.m[1] = (src_pts[2].x - src_pts[0].x) / target_height;
+        crop.m[2] = src_pts[0].x;
+        crop.m[3] = (src_pts[1].y - src_pts[0].y) / target_width;
+        crop.m[4] = (src_pts[2].y - src_pts[0].y) / target_height;
+        crop.m[5] = src_pts[0].y;
+        crop.width = target_width;
+        crop.height = target_height;
+        return crop;
+    }
+
+    // fn(index, ctx) is called once for every index, each lane leases one execution context
+    // and runs ncnn single threaded when several lanes are active
+    template <typename Fn>
+    void parallel_for(int n, Fn &&fn)
+    {
+        int lanes = std::min(n, num_workers);
+        std::atomic<int> next(0);
+        // pool threads charge their allocations to the caller's request
+        AllocationCounter *counter = AllocationScope::current();
+        auto lane = [&]() {
+            AllocationScope scope(counter);
+            auto ctx = contexts.acquire();
+            ctx->numThreads = lanes > 1 ? 1 : 0;
+            for (int i = next++; i < n; i = next++) {
+                fn(i, *ctx);
+            }
+        };
+        if (lanes > 1) {
+            pool->runLanes(lanes, lane);
         } else {
-            input = input_;
+            lane();
         }
-        
-        auto textBoxes = detect(input);
+    }
+
+    // a text line and the image it was detected in
+    struct LineRef {
+        const cv::Mat *image;
+        PixelFormat format;
+        TextBox *textBox;
+    };
+
+    std::vector<Textline> recognize(const ModelSet &set, const cv::Mat &input, PixelFormat format, std::vector<TextBox> &textBoxes, const RecognizerModel &model, RequestState &req)
+    {
+        std::vector<LineRef> lines(textBoxes.size());
+        for (size_t i = 0; i < textBoxes.size(); i++) {
+            lines[i] = LineRef{&input, format, &textBoxes[i]};
+        }
+        return recognize(set, lines, model, req);
+    }
+
+    // line indices grouped into width buckets of at most batch_size lines, narrowest first
+    std::vector<std::vector<int>> make_batches(const std::vector<int> &widths, int batch_size) const
+    {
+        int count = static_cast<int>(widths.size());
+
+        // sort lines by width, so lines of one batch have input shapes close to each other
+        std::vector<int> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&widths](int a, int b) {
+            return widths[a] < widths[b];
+        });
+
+        std::vector<std::vector<int>> batches;
+        for (int i = 0; i < count; i++) {
+            int idx = order[i];
+            if (batches.empty() || (int)batches.back().size() >= batch_size
+                || widths[idx] / rec_bucket_width != widths[batches.back()[0]] / rec_bucket_width) {
+                batches.emplace_back();
+            }
+            batches.back().push_back(idx);
+        }
+        return batches;
+    }
+
+    // crops classified one after another on one extractor, upside-down lines are turned in place
+    void orient(const ModelSet &set, std::vector<TextlineCrop> &crops, const std::vector<TextBox*> &textBoxes, ExecContext &ctx)
+    {
+        if (!set.textlineORI) {
+            return;
+        }
+        std::vector<size_t> classified;
+        std::vector<TextlineCrop> ori_crops;
+        for (size_t j = 0; j < crops.size(); j++) {
+            if (crops[j].width >= ori_min_aspect * crops[j].height) {
+                classified.push_back(j);
+                ori_crops.push_back(crops[j]);
+            }
+        }
+        auto ori_labels = set.textlineORI->forwardCrops(ori_crops, &ctx);
+        for (size_t k = 0; k < classified.size(); k++) {
+            if (ori_labels[k] == 1) {
+                // upside down
+                size_t j = classified[k];
+                rotate_crop_180(crops[j]);
+                textBoxes[j]->box.angle += 180.0f;
+            }
+        }
+    }
+
+    std::vector<Textline> read(const std::vector<TextlineCrop> &crops, const RecognizerModel &model, ExecContext &ctx)
+    {
+        auto textlines = model.recognizer->forwardCrops(crops, &ctx);
+        std::vector<Textline> results(crops.size());
+        for (size_t j = 0; j < crops.size(); j++) {
+            results[j] = decode(textlines[j], crops[j].width, model.vocab);
+        }
+        return results;
+    }
+
+    // recognizer of the request's language, null if it is unknown or fails to load. the request
+    // holds it until done, so evicting it meanwhile does not pull it from under the request
+    std::shared_ptr<const RecognizerModel> recognizer_for(const ModelSet &set, const RequestState &req)
+    {
+        if (req.language.empty()) {
+            return set.recognizer;
+        }
+        return recognizers.acquire(req.language);
+    }
+
+    void registerRecognizer(const std::string &language, const char *paramPath, const char *binPath, const char *vocabPath)
+    {
+        recognizers.add(language, paramPath, binPath, vocabPath);
+    }
+
+    void registerRecognizerBundle(const std::string &language, const char *bundlePath)
+    {
+        recognizers.addBundle(language, bundlePath);
+    }
+
+    RecognizerStats recognizerStats() const
+    {
+        return recognizers.stats();
+    }
+
+    // lines of any number of images share the same width buckets, every batch is one
+    // scheduler unit, batches left after the deadline are skipped
+    std::vector<Textline> recognize(const ModelSet &set, const std::vector<LineRef> &lines, const RecognizerModel &model, RequestState &req)
+    {
+        int count = static_cast<int>(lines.size());
+
+        std::vector<int> widths(count);
+        for (int i = 0; i < count; i++) {
+            widths[i] = line_width(*lines[i].textBox);
+        }
+
+        // with several workers keep at least one batch per worker
+        int batch_size = rec_batch_size;
+        if (num_workers > 1) {
+            int lanes = num_workers;
+            batch_size = std::max(1, std::min(batch_size, (count + lanes - 1) / lanes));
+        }
+        auto batches = make_batches(widths, batch_size);
+
+        std::vector<Textline> results(count);
+        parallel_for(static_cast<int>(batches.size()), [&](int b, ExecContext &ctx) {
+            if (!scheduler.acquire(Scheduler::Recognize, req)) {
+                return;
+            }
+            const auto &batch = batches[b];
+            std::vector<TextlineCrop> crops(batch.size());
+            std::vector<TextBox*> textBoxes(batch.size());
+            for (size_t j = 0; j < batch.size(); j++) {
+                crops[j] = crop(*lines[batch[j]].image, lines[batch[j]].format, *lines[batch[j]].textBox);
+                textBoxes[j] = lines[batch[j]].textBox;
+            }
+
+            // orientation before the recognizer sees the batch
+            ctx.request = &req;
+            orient(set, crops, textBoxes, ctx);
+
+            auto textlines = read(crops, model, ctx);
+            for (size_t j = 0; j < batch.size(); j++) {
+                results[batch[j]] = std::move(textlines[j]);
+            }
+            scheduler.release(Scheduler::Recognize);
+        });
+
+        return results;
+    }
+
+    // boxes found on a copy shrunk by (scale_x, scale_y), mapped back to the full image
+    static void scale_boxes(std::vector<TextBox> &textBoxes, float scale_x, float scale_y)
+    {
+        float scale = 0.5f * (scale_x + scale_y);
+        for (auto &textBox : textBoxes) {
+            textBox.box.center.x = (textBox.box.center.x + 0.5f) * scale_x - 0.5f;
+            textBox.box.center.y = (textBox.box.center.y + 0.5f) * scale_y - 0.5f;
+            textBox.box.size.width *= scale;
+            textBox.box.size.height *= scale;
+        }
+    }
+
+    static void sort_boxes(std::vector<TextBox> &textBoxes)
+    {
         // sort textBoxes top to bottom, left to right
         std::sort(textBoxes.begin(), textBoxes.end(), [](const TextBox &a, const TextBox &b) {
             float ay = a.box.center.y;
@@ -344,9 +996,193 @@ public:
             }
             return ay < by;
         });
+    }
 
-        auto textlines = recognize(input, textBoxes);
-        return {textBoxes, textlines};
+    std::vector<TextBox> detect_scheduled(const ModelSet &set, const cv::Mat &input, PixelFormat format, RequestState &req, ExecContext *ctx = nullptr)
+    {
+        if (!ctx) {
+            auto lease = contexts.acquire();
+            return detect_scheduled(set, input, format, req, lease.get());
+        }
+        if (!scheduler.acquire(Scheduler::Detect, req)) {
+            return {};
+        }
+        ctx->request = &req;
+        auto textBoxes = detect(set, input, format, ctx);
+        scheduler.release(Scheduler::Detect);
+        sort_boxes(textBoxes);
+        return textBoxes;
+    }
+
+    // input is read in place in its own pixel format, the models convert while they sample it
+    std::pair<std::vector<TextBox>, std::vector<Textline>> run(const cv::Mat &input, PixelFormat format, RequestState &req)
+    {
+        if (input.empty()) {
+            return {{}, {}};
+        }
+
+        // before detection, a request for an unknown language fails without any work
+        auto set = current();
+        auto model = recognizer_for(*set, req);
+        if (!model) {
+            req.set(RequestStatus::Failed);
+            return {{}, {}};
+        }
+
+        std::pair<std::vector<TextBox>, std::vector<Textline>> result;
+        {
+            AllocationScope scope(&req.allocations);
+            auto textBoxes = detect_scheduled(*set, input, format, req);
+
+            auto textlines = recognize(*set, input, format, textBoxes, *model, req);
+            if (!req.dropped()) {
+                result = {std::move(textBoxes), std::move(textlines)};
+            }
+        }
+        req.reportAllocations();
+        return result;
+    }
+
+    // how much the detector shrinks a width x height image by itself, 1 when it reads it whole
+    double detect_downscale(int width, int height) const
+    {
+        // tiles and the fine pass of coarse-to-fine read the full resolution image
+        if (det_tile_size > 0 || (det_coarse_scale > 0.f && det_coarse_scale < 1.f)) {
+            return 1.0;
+        }
+        double factor = 1.0;
+        if (det_limit_side_len > 0) {
+            factor = std::max(factor, static_cast<double>(std::max(width, height)) / det_limit_side_len);
+        }
+        if (det_max_pixels > 0) {
+            factor = std::max(factor, std::sqrt(static_cast<double>(width) * height / det_max_pixels));
+        }
+        return factor;
+    }
+
+    // encoded input, decoded from the caller's bytes. when the detector would shrink the image
+    // anyway, detection runs on a reduced JPEG decode while the full resolution decode the
+    // crops need runs next to it
+    std::pair<std::vector<TextBox>, std::vector<Textline>> run_encoded(const unsigned char *data, int size, RequestState &req)
+    {
+        int width = 0, height = 0;
+        int reduction = 1;
+        if (jpeg_size(data, size, width, height)) {
+            reduction = decode_reduction(detect_downscale(width, height));
+        }
+        if (reduction == 1) {
+            return run(decode_image(data, size), PixelFormat::BGR, req);
+        }
+        auto set = current();
+        auto model = recognizer_for(*set, req);
+        if (!model) {
+            req.set(RequestStatus::Failed);
+            return {{}, {}};
+        }
+
+        std::pair<std::vector<TextBox>, std::vector<Textline>> result;
+        {
+            AllocationScope scope(&req.allocations);
+            cv::Mat full;
+            cv::Size reduced_size;
+            std::vector<TextBox> textBoxes;
+
+            // two lanes, the caller runs whatever the pool does not pick up
+            std::atomic<int> next(0);
+            AllocationCounter *counter = AllocationScope::current();
+            pool->runLanes(2, [&]() {
+                AllocationScope lane_scope(counter);
+                for (int i = next++; i < 2; i = next++) {
+                    if (i == 0) {
+                        cv::Mat reduced = decode_image(data, size, reduction);
+                        if (!reduced.empty()) {
+                            reduced_size = reduced.size();
+                            textBoxes = detect_scheduled(*set, reduced, PixelFormat::BGR, req);
+                        }
+                    } else {
+                        full = decode_image(data, size);
+                    }
+                }
+            });
+
+            if (!full.empty() && reduced_size.width == 0) {
+                // the reduced decode failed where the full one did not
+                textBoxes = detect_scheduled(*set, full, PixelFormat::BGR, req);
+            } else if (!full.empty()) {
+                scale_boxes(textBoxes, static_cast<float>(full.cols) / reduced_size.width, static_cast<float>(full.rows) / reduced_size.height);
+                sort_boxes(textBoxes);
+            }
+            if (!full.empty()) {
+                auto textlines = recognize(*set, full, PixelFormat::BGR, textBoxes, *model, req);
+                if (!req.dropped()) {
+                    result = {std::move(textBoxes), std::move(textlines)};
+                }
+            }
+        }
+        req.reportAllocations();
+        return result;
+    }
+
+    SchedulerStats schedulerStats()
+    {
+        SchedulerStats stats;
+        stats.detect = scheduler.stats(Scheduler::Detect);
+        stats.recognize = scheduler.stats(Scheduler::Recognize);
+        return stats;
+    }
+
+    AllocatorStats allocatorStats() const
+    {
+        return contexts.allocatorStats();
+    }
+
+    // detection per image, then the lines of all images go through recognition together,
+    // so many small images still fill whole groups. the whole batch is one request: one
+    // language, priority, deadline, cancel token and budget, one status
+    std::vector<std::pair<std::vector<TextBox>, std::vector<Textline>>> run_batch(const std::vector<const cv::Mat*> &inputs, RequestState &req)
+    {
+        int count = static_cast<int>(inputs.size());
+        std::vector<std::pair<std::vector<TextBox>, std::vector<Textline>>> results(count);
+
+        auto set = current();
+        auto model = recognizer_for(*set, req);
+        if (!model) {
+            req.set(RequestStatus::Failed);
+            return results;
+        }
+
+        std::vector<std::vector<TextBox>> textBoxes(count);
+        std::vector<Textline> textlines;
+        {
+            AllocationScope scope(&req.allocations);
+            parallel_for(count, [&](int i, ExecContext &ctx) {
+                if (!inputs[i] || inputs[i]->empty() || req.stopped()) {
+                    return;
+                }
+                textBoxes[i] = detect_scheduled(*set, *inputs[i], default_format(inputs[i]->channels()), req, &ctx);
+            });
+
+            std::vector<LineRef> lines;
+            for (int i = 0; i < count; i++) {
+                for (auto &textBox : textBoxes[i]) {
+                    lines.push_back(LineRef{inputs[i], default_format(inputs[i]->channels()), &textBox});
+                }
+            }
+            textlines = recognize(*set, lines, *model, req);
+        }
+        req.reportAllocations();
+        if (req.dropped()) {
+            return results;
+        }
+
+        auto next = textlines.begin();
+        for (int i = 0; i < count; i++) {
+            auto end = next + textBoxes[i].size();
+            results[i].second.assign(std::make_move_iterator(next), std::make_move_iterator(end));
+            results[i].first = std::move(textBoxes[i]);
+            next = end;
+        }
+        return results;
     }
 };
 
@@ -375,37 +1211,342 @@ bool LiteOCREngine::loadModelFromBuffer(const char* detParamBuffer, const unsign
                                     vocabBuffer, oriParamBuffer, oriBinBuffer, opt);
 }
 
-std::pair<std::vector<TextBox>, std::vector<Textline>> LiteOCREngine::recognize(const void *cvMat) {
+bool LiteOCREngine::loadBundle(const char* bundlePath, const InferOption &opt) {
+    impl = std::make_unique<LiteOCREngineImpl>();
+    return impl->loadBundle(bundlePath, opt);
+}
+
+bool LiteOCREngine::reloadModel(const char* detParamPath, const char* detBinPath,
+                                const char* recParamPath, const char* recBinPath,
+                                const char* vocabPath,
+                                const char* oriParamPath, const char* oriBinPath) {
+    if (!impl) {
+        fprintf(stderr, "[LiteOCR]reloadModel called before any model was loaded\n");
+        return false;
+    }
+    return impl->reloadModel(detParamPath, detBinPath, recParamPath, recBinPath, vocabPath, oriParamPath, oriBinPath);
+}
+
+bool LiteOCREngine::reloadBundle(const char* bundlePath) {
+    if (!impl) {
+        fprintf(stderr, "[LiteOCR]reloadBundle called before any model was loaded\n");
+        return false;
+    }
+    return impl->reloadBundle(bundlePath);
+}
+
+std::pair<std::vector<TextBox>, std::vector<Textline>> LiteOCREngine::recognize(const void *cvMat, const RequestOption &req, RequestStatus *status) {
     const cv::Mat* mat = static_cast<const cv::Mat*>(cvMat);
-    return impl->run(*mat);
+    RequestState state(req);
+    auto result = impl->run(*mat, default_format(mat->channels()), state);
+    if (status) *status = state.get();
+    return result;
 }
 
-std::pair<std::vector<TextBox>, std::vector<Textline>> LiteOCREngine::recognize(const unsigned char* imgData, int width, int height, int channels, int cstep) {
-    cv::Mat img(height, width, (channels == 1) ? CV_8UC1 : ((channels == 3) ? CV_8UC3 : CV_8UC4), (void*)imgData, cstep);
-    return impl->run(img);
+std::pair<std::vector<TextBox>, std::vector<Textline>> LiteOCREngine::recognize(const unsigned char* imgData, int width, int height, int channels, int cstep, const RequestOption &req, RequestStatus *status) {
+    return recognize(imgData, width, height, default_format(channels), cstep, req, status);
+}
+
+std::pair<std::vector<TextBox>, std::vector<Textline>> LiteOCREngine::recognize(const unsigned char* imgData, int width, int height, PixelFormat format, int stride, const RequestOption &req, RequestStatus *status) {
+    // a header over the caller's rows, nothing is copied
+    cv::Mat img(height, width, CV_8UC(pixel_channels(format)), (void*)imgData, stride);
+    RequestState state(req);
+    auto result = impl->run(img, format, state);
+    if (status) *status = state.get();
+    return result;
+}
+
+std::pair<std::vector<TextBox>, std::vector<Textline>> LiteOCREngine::recognize(const unsigned char* imgData, int size, const RequestOption &req, RequestStatus *status) {
+    RequestState state(req);
+    auto result = impl->run_encoded(imgData, size, state);
+    if (status) *status = state.get();
+    return result;
+}
+
+std::vector<std::pair<std::vector<TextBox>, std::vector<Textline>>> LiteOCREngine::recognizeBatch(const std::vector<const void*> &cvMats, const RequestOption &req, RequestStatus *status) {
+    std::vector<const cv::Mat*> mats(cvMats.size());
+    for (size_t i = 0; i < cvMats.size(); i++) {
+        mats[i] = static_cast<const cv::Mat*>(cvMats[i]);
+    }
+    RequestState state(req);
+    auto results = impl->run_batch(mats, state);
+    if (status) *status = state.get();
+    return results;
+}
+
+std::future<std::pair<std::vector<TextBox>, std::vector<Textline>>> LiteOCREngine::recognizeAsync(const void *cvMat, const RequestOption &req) {
+    auto promise = std::make_shared<std::promise<std::pair<std::vector<TextBox>, std::vector<Textline>>>>();
+    auto future = promise->get_future();
+    recognizeAsync(cvMat, [promise](std::pair<std::vector<TextBox>, std::vector<Textline>> result) {
+        promise->set_value(std::move(result));
+    }, req);
+    return future;
+}
+
+std::future<std::pair<std::vector<TextBox>, std::vector<Textline>>> LiteOCREngine::recognizeAsync(const unsigned char* imgData, int size, const RequestOption &req) {
+    auto promise = std::make_shared<std::promise<std::pair<std::vector<TextBox>, std::vector<Textline>>>>();
+    auto future = promise->get_future();
+    recognizeAsync(imgData, size, [promise](std::pair<std::vector<TextBox>, std::vector<Textline>> result) {
+        promise->set_value(std::move(result));
+    }, req);
+    return future;
+}
+
+void LiteOCREngine::registerRecognizer(const std::string &language, const char* paramPath, const char* binPath, const char* vocabPath) {
+    impl->registerRecognizer(language, paramPath, binPath, vocabPath);
+}
+
+void LiteOCREngine::registerRecognizerBundle(const std::string &language, const char* bundlePath) {
+    impl->registerRecognizerBundle(language, bundlePath);
+}
+
+RecognizerStats LiteOCREngine::recognizerStats() const {
+    return impl->recognizerStats();
+}
+
+void LiteOCREngine::recognizeAsync(const void *cvMat, std::function<void(std::pair<std::vector<TextBox>, std::vector<Textline>>)> callback, const RequestOption &req) {
+    // copy the header only, the caller keeps the pixels alive
+    cv::Mat img = *static_cast<const cv::Mat*>(cvMat);
+    // the deadline counts from now, time in the queue included
+    auto state = std::make_shared<RequestState>(req);
+    LiteOCREngineImpl* engine = impl.get();
+    engine->submit([engine, img, state, callback = std::move(callback)]() {
+        callback(engine->run(img, default_format(img.channels()), *state));
+    });
+}
+
+void LiteOCREngine::recognizeAsync(const unsigned char* imgData, int size, std::function<void(std::pair<std::vector<TextBox>, std::vector<Textline>>)> callback, const RequestOption &req) {
+    auto data = std::make_shared<std::vector<unsigned char>>(imgData, imgData + size);
+    auto state = std::make_shared<RequestState>(req);
+    LiteOCREngineImpl* engine = impl.get();
+    engine->submit([engine, data, state, callback = std::move(callback)]() {
+        if (state->stopped() || std::chrono::steady_clock::now() >= state->deadline) {
+            // do not even decode a request which is late already
+            callback({{}, {}});
+            return;
+        }
+        // decode on the pool as well, so the caller never waits for it
+        callback(engine->run_encoded(data->data(), static_cast<int>(data->size()), *state));
+    });
+}
+
+SchedulerStats LiteOCREngine::schedulerStats() const {
+    return impl->schedulerStats();
+}
+
+AllocatorStats LiteOCREngine::allocatorStats() const {
+    return impl->allocatorStats();
+}
+
+StartupStats LiteOCREngine::warmup(const WarmupOption &opt) {
+    return impl->warmup(opt);
 }
 
-std::pair<std::vector<TextBox>, std::vector<Textline>> LiteOCREngine::recognize(const unsigned char* imgData, int size) {
-    std::vector<unsigned char> data(imgData, imgData + size);
-    cv::Mat img = cv::imdecode(data, cv::IMREAD_COLOR);
-    return impl->run(img);
+StartupStats LiteOCREngine::startupStats() const {
+    return impl->startupStats();
+}
+
+class LiteOCRStreamImpl {
+private:
+    struct Item {
+        uint64_t id = 0;
+        std::shared_ptr<const ModelSet> models; // the engine's set at push, a reload does not change it midway
+        std::vector<unsigned char> encoded;
+        cv::Mat image;
+        std::vector<TextBox> textBoxes;
+        std::vector<TextlineCrop> crops;
+        std::vector<Textline> textlines;
+    };
+
+    LiteOCREngineImpl &engine;
+    int rec_batch_size;
+
+    // input -> decoded -> detected -> cropped -> output
+    std::vector<std::unique_ptr<BoundedQueue<Item>>> queues;
+    std::vector<std::thread> threads;
+
+    // threads pull from queue `stage` and push to queue `stage + 1`, the last one to finish
+    // closes the next queue
+    template <typename Fn>
+    void add_stage(int stage, int numThreads, int ncnnThreads, Fn fn)
+    {
+        numThreads = std::max(1, numThreads);
+        auto remaining = std::make_shared<std::atomic<int>>(numThreads);
+        for (int t = 0; t < numThreads; t++) {
+            threads.emplace_back([this, stage, ncnnThreads, fn, remaining]() {
+                auto lease = engine.leaseContext();
+                ExecContext &ctx = *lease;
+                ctx.numThreads = std::max(0, ncnnThreads);
+                BoundedQueue<Item> &in = *queues[stage];
+                BoundedQueue<Item> &out = *queues[stage + 1];
+                Item item;
+                while (in.pop(item)) {
+                    fn(item, ctx);
+                    if (!out.push(std::move(item))) break;
+                }
+                if (--*remaining == 0) {
+                    out.close();
+                }
+            });
+        }
+    }
+
+public:
+    LiteOCRStreamImpl(LiteOCREngineImpl &engine, const StreamOption &opt)
+        : engine(engine), rec_batch_size(engine.recBatchSize())
+    {
+        for (int i = 0; i < 5; i++) {
+            queues.emplace_back(new BoundedQueue<Item>(std::max(1, opt.queueDepth)));
+        }
+
+        add_stage(0, opt.decodeThreads, 0, [](Item &item, ExecContext &) {
+            // gray and BGRA images go on as they are, later stages read them in place
+            if (item.image.empty() && !item.encoded.empty()) {
+                item.image = cv::imdecode(item.encoded, cv::IMREAD_COLOR);
+                item.encoded = std::vector<unsigned char>();
+            }
+        });
+
+        add_stage(1, opt.detectThreads, opt.detectNumThreads, [this](Item &item, ExecContext &ctx) {
+            if (item.image.empty()) return;
+            item.textBoxes = this->engine.detect(*item.models, item.image, default_format(item.image.channels()), &ctx);
+            LiteOCREngineImpl::sort_boxes(item.textBoxes);
+        });
+
+        add_stage(2, opt.cropThreads, opt.cropNumThreads, [this](Item &item, ExecContext &ctx) {
+            std::vector<TextBox*> textBoxes(item.textBoxes.size());
+            item.crops.resize(item.textBoxes.size());
+            for (size_t i = 0; i < item.textBoxes.size(); i++) {
+                item.crops[i] = this->engine.crop(item.image, default_format(item.image.channels()), item.textBoxes[i]);
+                textBoxes[i] = &item.textBoxes[i];
+            }
+            this->engine.orient(*item.models, item.crops, textBoxes, ctx);
+        });
+
+        add_stage(3, opt.recognizeThreads, opt.recognizeNumThreads, [this](Item &item, ExecContext &ctx) {
+            std::vector<int> widths(item.crops.size());
+            for (size_t i = 0; i < item.crops.size(); i++) {
+                widths[i] = item.crops[i].width;
+            }
+            item.textlines.resize(item.crops.size());
+            for (const auto &batch : this->engine.make_batches(widths, rec_batch_size)) {
+                std::vector<TextlineCrop> crops(batch.size());
+                for (size_t j = 0; j < batch.size(); j++) {
+                    crops[j] = item.crops[batch[j]];
+                }
+                auto textlines = this->engine.read(crops, *item.models->recognizer, ctx);
+                for (size_t j = 0; j < batch.size(); j++) {
+                    item.textlines[batch[j]] = std::move(textlines[j]);
+                }
+            }
+            // the source image is no longer needed, let the caller reuse it early
+            item.crops.clear();
+            item.image.release();
+        });
+    }
+
+    ~LiteOCRStreamImpl()
+    {
+        for (auto &queue : queues) {
+            queue->close();
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+
+    bool push(Item item)
+    {
+        item.models = engine.current();
+        return queues.front()->push(std::move(item));
+    }
+
+    bool push(uint64_t id, const cv::Mat &image)
+    {
+        Item item;
+        item.id = id;
+        item.image = image;
+        return push(std::move(item));
+    }
+
+    bool push(uint64_t id, const unsigned char* imgData, int size)
+    {
+        Item item;
+        item.id = id;
+        item.encoded.assign(imgData, imgData + size);
+        return push(std::move(item));
+    }
+
+    void close()
+    {
+        queues.front()->close();
+    }
+
+    bool pop(StreamResult &result)
+    {
+        Item item;
+        if (!queues.back()->pop(item)) {
+            return false;
+        }
+        result.id = item.id;
+        result.textBoxes = std::move(item.textBoxes);
+        result.textlines = std::move(item.textlines);
+        return true;
+    }
+};
+
+LiteOCRStream::LiteOCRStream(LiteOCREngine &engine, const StreamOption &opt)
+    : impl(std::make_unique<LiteOCRStreamImpl>(*engine.impl, opt)) {}
+
+LiteOCRStream::~LiteOCRStream() = default;
+
+bool LiteOCRStream::push(uint64_t id, const void *cvMat) {
+    return impl->push(id, *static_cast<const cv::Mat*>(cvMat));
+}
+
+bool LiteOCRStream::push(uint64_t id, const unsigned char* imgData, int size) {
+    return impl->push(id, imgData, size);
+}
+
+void LiteOCRStream::close() {
+    impl->close();
+}
+
+bool LiteOCRStream::pop(StreamResult &result) {
+    return impl->pop(result);
 }
 
 class LiteOCRTableEngineImpl {
 private:
+    LiteOCR::ModelBundle bundle; // weights of a loadBundle engine, outlives slaNet
     std::unique_ptr<LiteOCR::PaddleSLANet> slaNet;
+    LiteOCR::ExecContextPool contexts;
+    LiteOCR::StartupStats startup;
 
 public:
     LiteOCRTableEngineImpl() {
         
     }
 
+    void configure(const LiteOCR::InferOption &opt) {
+        contexts.configure(static_cast<size_t>(std::max(0, opt.poolCapMB)) << 20);
+        if (opt.countAllocations) {
+            install_counting_mat_allocator();
+        }
+    }
+
     bool loadModel(const char* cnnParamPath, const char* cnnBinPath,
                    const char* slaheadParamPath, const char* slaheadBinPath,
                    const char* vocabPath,
                    const LiteOCR::InferOption &opt) {
         slaNet = std::make_unique<LiteOCR::PaddleSLANet>();
-        return slaNet->loadModel(cnnParamPath, cnnBinPath, slaheadParamPath, slaheadBinPath, vocabPath, opt);
+        configure(opt);
+        auto start = std::chrono::steady_clock::now();
+        if (!slaNet->loadModel(cnnParamPath, cnnBinPath, slaheadParamPath, slaheadBinPath, vocabPath, opt)) {
+            return false;
+        }
+        startup_stage(startup, "table").loadMs = elapsed_ms(start);
+        return true;
     }
 
     bool loadModelFromBuffer(const char* cnnParamBuffer, const unsigned char* cnnBinBuffer,
@@ -413,12 +1554,108 @@ public:
                              const char* vocabBuffer,
                              const LiteOCR::InferOption &opt) {
         slaNet = std::make_unique<LiteOCR::PaddleSLANet>();
-        return slaNet->loadModelFromBuffer(cnnParamBuffer, cnnBinBuffer, slaheadParamBuffer, slaheadBinBuffer, vocabBuffer, opt);
+        configure(opt);
+        auto start = std::chrono::steady_clock::now();
+        if (!slaNet->loadModelFromBuffer(cnnParamBuffer, cnnBinBuffer, slaheadParamBuffer, slaheadBinBuffer, vocabBuffer, opt)) {
+            return false;
+        }
+        startup_stage(startup, "table").loadMs = elapsed_ms(start);
+        return true;
+    }
+
+    bool loadBundle(const char* bundlePath, const LiteOCR::InferOption &opt) {
+        auto start = std::chrono::steady_clock::now();
+        if (!bundle.open(bundlePath)) {
+            fprintf(stderr, "[LiteOCR]Failed to open model bundle %s\n", bundlePath);
+            return false;
+        }
+        const char* cnnParam = bundle.param("table_cnn.param");
+        const unsigned char* cnnBin = bundle.data("table_cnn.bin");
+        const char* slaheadParam = bundle.param("table_head.param");
+        const unsigned char* slaheadBin = bundle.data("table_head.bin");
+        std::vector<std::string_view> tokens;
+        if (!cnnParam || !cnnBin || !slaheadParam || !slaheadBin || !bundle.vocab("table.vocab", tokens)) {
+            fprintf(stderr, "[LiteOCR]Model bundle %s has no table models and vocab\n", bundlePath);
+            return false;
+        }
+        startup_stage(startup, "bundle").loadMs = elapsed_ms(start);
+        slaNet = std::make_unique<LiteOCR::PaddleSLANet>();
+        configure(opt);
+        start = std::chrono::steady_clock::now();
+        // a few dozen structure tokens, copied since SLANet keeps them as strings
+        if (!slaNet->loadModelFromBuffer(cnnParam, cnnBin, slaheadParam, slaheadBin, std::vector<std::string>(tokens.begin(), tokens.end()), opt)) {
+            return false;
+        }
+        startup_stage(startup, "table").loadMs = elapsed_ms(start);
+        return true;
+    }
+
+    // the structure model always sees inputSize x inputSize, one page covers every shape it runs
+    LiteOCR::StartupStats warmup()
+    {
+        int size = slaNet->inputSize();
+        cv::Mat page = synthetic_text(size, size, std::max(16, size / 20));
+        auto start = std::chrono::steady_clock::now();
+        auto ctx = contexts.acquire();
+        slaNet->forward(page, ctx.get());
+        startup_stage(startup, "table").warmupMs = elapsed_ms(start);
+        startup.warm = true;
+        return startup;
     }
 
-    std::pair<std::string,std::vector<Rect>> run(const cv::Mat &input, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult) {
-        auto table_structure = slaNet->forward(input);
-        return merge_table_ocr(table_structure, ocrResult.first, ocrResult.second);
+    LiteOCR::StartupStats startupStats() const
+    {
+        return startup;
+    }
+
+    // full_size is the size ocrResult was found at when input is a reduced decode of it
+    std::pair<std::string,std::vector<Rect>> run(const cv::Mat &input, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, RequestState &req, cv::Size full_size = cv::Size()) {
+        std::pair<std::string,std::vector<Rect>> result;
+        {
+            AllocationScope scope(&req.allocations);
+            auto ctx = contexts.acquire();
+            ctx->request = &req;
+            auto table_structure = slaNet->forward(input, ctx.get());
+            if (full_size.width > 0 && full_size != input.size()) {
+                float sx = static_cast<float>(full_size.width) / input.cols;
+                float sy = static_cast<float>(full_size.height) / input.rows;
+                for (auto &entry : table_structure) {
+                    for (int i = 0; i < 8; i += 2) {
+                        entry.second[i] *= sx;
+                        entry.second[i + 1] *= sy;
+                    }
+                }
+            }
+            result = merge_table_ocr(table_structure, ocrResult.first, ocrResult.second);
+        }
+        req.reportAllocations();
+        return result;
+    }
+
+    // the structure model only sees the image at inputSize, a JPEG is decoded no larger than that needs
+    std::pair<std::string,std::vector<Rect>> run_encoded(const unsigned char *data, int size, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, RequestState &req) {
+        int width = 0, height = 0;
+        int reduction = 1;
+        if (jpeg_size(data, size, width, height)) {
+            reduction = decode_reduction(static_cast<double>(std::min(width, height)) / slaNet->inputSize());
+        }
+        cv::Mat img = decode_image(data, size, reduction);
+        if (img.empty()) {
+            return {};
+        }
+        cv::Size full_size = img.size();
+        if (reduction > 1) {
+            full_size = cv::Size(width, height);
+            // the decoder applies the EXIF orientation, the frame header does not
+            if ((img.cols > img.rows) != (width > height)) {
+                std::swap(full_size.width, full_size.height);
+            }
+        }
+        return run(img, ocrResult, req, full_size);
+    }
+
+    AllocatorStats allocatorStats() const {
+        return contexts.allocatorStats();
     }
 };
 
@@ -442,19 +1679,43 @@ bool LiteOCRTableEngine::loadModelFromBuffer(const char* cnnParamBuffer, const u
     return impl->loadModelFromBuffer(cnnParamBuffer, cnnBinBuffer, slaheadParamBuffer, slaheadBinBuffer, vocabBuffer, opt);
 }
 
-std::pair<std::string,std::vector<Rect>> LiteOCRTableEngine::recognize(const void *cvMat, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult) {
+bool LiteOCRTableEngine::loadBundle(const char* bundlePath, const InferOption &opt) {
+    impl = std::make_unique<LiteOCRTableEngineImpl>();
+    return impl->loadBundle(bundlePath, opt);
+}
+
+std::pair<std::string,std::vector<Rect>> LiteOCRTableEngine::recognize(const void *cvMat, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, const RequestOption &req, RequestStatus *status) {
     const cv::Mat* mat = static_cast<const cv::Mat*>(cvMat);
-    return impl->run(*mat, ocrResult);
+    RequestState state(req);
+    auto result = impl->run(*mat, ocrResult, state);
+    if (status) *status = state.get();
+    return result;
 }
 
-std::pair<std::string,std::vector<Rect>> LiteOCRTableEngine::recognize(const unsigned char* imgData, int width, int height, int channels, int cstep, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult) {
+std::pair<std::string,std::vector<Rect>> LiteOCRTableEngine::recognize(const unsigned char* imgData, int width, int height, int channels, int cstep, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, const RequestOption &req, RequestStatus *status) {
     cv::Mat img(height, width, (channels == 1) ? CV_8UC1 : ((channels == 3) ? CV_8UC3 : CV_8UC4), (void*)imgData, cstep);
-    return impl->run(img, ocrResult);
+    RequestState state(req);
+    auto result = impl->run(img, ocrResult, state);
+    if (status) *status = state.get();
+    return result;
+}
+
+std::pair<std::string,std::vector<Rect>> LiteOCRTableEngine::recognize(const unsigned char* imgData, int size, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult, const RequestOption &req, RequestStatus *status) {
+    RequestState state(req);
+    auto result = impl->run_encoded(imgData, size, ocrResult, state);
+    if (status) *status = state.get();
+    return result;
+}
+
+AllocatorStats LiteOCRTableEngine::allocatorStats() const {
+    return impl->allocatorStats();
+}
+
+StartupStats LiteOCRTableEngine::warmup() {
+    return impl->warmup();
 }
 
-std::pair<std::string,std::vector<Rect>> LiteOCRTableEngine::recognize(const unsigned char* imgData, int size, const std::pair<std::vector<TextBox>, std::vector<Textline>> ocrResult) {
-    std::vector<unsigned char> data(imgData, imgData + size);
-    cv::Mat img = cv::imdecode(data, cv::IMREAD_COLOR);
-    return impl->run(img, ocrResult);
+StartupStats LiteOCRTableEngine::startupStats() const {
+    return impl->startupStats();
 }
 } // namespace LiteOCR
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+namespace LiteOCR {
+
+    // read only mapping of a whole file. the pages come from the page cache, so processes
+    // mapping the same weights share one copy and nothing is read until it is touched
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // drops any previous mapping first, false if the file can not be opened or is empty
+        bool open(const char* path);
+        void close();
+
+        const unsigned char* data() const { return static_cast<const unsigned char*>(addr); }
+        size_t size() const { return length; }
+        bool isOpen() const { return addr != nullptr; }
+
+    private:
+        void* addr = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        void* mapping = nullptr;
+#endif
+    };
+
+} // namespace LiteOCR
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "LiteOCREngine.h"
+
+#include <ncnn/allocator.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <utility>
+
+namespace LiteOCR {
+
+    // shared by every allocator of one engine
+    struct AllocatorCounters {
+        std::atomic<uint64_t> heapAllocations{0};
+        std::atomic<uint64_t> pooledAllocations{0};
+        std::atomic<uint64_t> released{0};
+        std::atomic<int64_t> retainedBytes{0};
+
+        AllocatorStats snapshot() const {
+            AllocatorStats stats;
+            stats.heapAllocations = heapAllocations.load();
+            stats.pooledAllocations = pooledAllocations.load();
+            stats.released = released.load();
+            stats.retainedBytes = static_cast<size_t>(std::max<int64_t>(0, retainedBytes.load()));
+            return stats;
+        }
+    };
+
+    // size matched free list like ncnn::PoolAllocator, keeps at most cap bytes of free blocks
+    // and counts how many blobs still come from the heap. unlocked for blobs, which are only
+    // touched by the thread driving the extractor, locked for workspace used by ncnn threads
+    class CappedPoolAllocator : public ncnn::Allocator {
+    public:
+        explicit CappedPoolAllocator(bool locked) : locked(locked) {}
+        ~CappedPoolAllocator() override;
+
+        CappedPoolAllocator(const CappedPoolAllocator&) = delete;
+        CappedPoolAllocator& operator=(const CappedPoolAllocator&) = delete;
+
+        // 0 gives every block back at once
+        void setCap(size_t bytes);
+        void setCounters(AllocatorCounters* counters);
+
+        void* fastMalloc(size_t size) override;
+        void fastFree(void* ptr) override;
+
+        // give all free blocks back to the heap
+        void clear();
+
+    private:
+        // caller holds the lock
+        void trim(size_t cap_bytes);
+
+        const bool locked;
+        std::mutex mutex;
+        size_t cap = 64u << 20;
+        size_t retained = 0;
+        std::list<std::pair<size_t, void*>> budgets; // free blocks, most recently freed last
+        std::list<std::pair<size_t, void*>> payouts; // blocks in use
+        AllocatorCounters* counters = nullptr;
+    };
+
+} // namespace LiteOCR
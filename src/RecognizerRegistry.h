@@ -0,0 +1,77 @@
+#pragma once
+
+#include "LiteOCREngine.h"
+#include "BaseInfer.h"
+#include "Bundle.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace LiteOCR {
+
+    // a recognizer and the vocab its output indexes
+    struct RecognizerModel {
+        std::unique_ptr<ModelBundle> bundle; // entries the recognizer reads in place, outlives it
+        std::unique_ptr<BaseRecognizer> recognizer;
+        std::vector<std::string_view> vocab; // into the bundle mapping or vocab_text
+        std::string vocab_text; // token bytes of a vocab read from a file or buffer
+        size_t bytes = 0; // weights and vocab, what the registry charges to its budget
+    };
+
+    // one token per line of text, split like std::getline. the tokens view the copy kept in model
+    void set_vocab(RecognizerModel& model, std::string text);
+    // vocab file read into model, false if it cannot be opened
+    bool read_vocab(RecognizerModel& model, const char* vocabPath);
+
+    // loads a recognizer and vocab from files, null on failure
+    std::shared_ptr<RecognizerModel> load_recognizer(const char* paramPath, const char* binPath, const char* vocabPath, const InferOption& opt);
+    // rec.param, rec.bin and rec.vocab of a bundle
+    std::shared_ptr<RecognizerModel> load_recognizer_bundle(const char* bundlePath, const InferOption& opt);
+
+    // recognizers by language, loaded on first acquire. past the budget the least recently used
+    // ones are unloaded. a request keeps the model it acquired, so an unloaded model is freed
+    // once the last request reading with it is done
+    class RecognizerRegistry {
+    public:
+        // options models are loaded with, and the budget in bytes, 0 means no limit
+        void configure(const InferOption& opt, size_t budget);
+
+        // replaces any model registered for language, a loaded one is unloaded
+        void add(const std::string& language, const char* paramPath, const char* binPath, const char* vocabPath);
+        void addBundle(const std::string& language, const char* bundlePath);
+
+        // loads on a miss, other languages are served meanwhile. null for an unknown language or
+        // when loading fails
+        std::shared_ptr<const RecognizerModel> acquire(const std::string& language);
+
+        RecognizerStats stats() const;
+
+    private:
+        struct Entry {
+            std::string paramPath, binPath, vocabPath, bundlePath;
+            std::shared_ptr<const RecognizerModel> model;
+            std::shared_ptr<std::mutex> loading; // one loader per language, held without the registry lock
+            uint64_t generation = 0; // changes when the language is registered again
+        };
+
+        void unload(const std::string& language);
+        void evict();
+
+        mutable std::mutex mutex;
+        InferOption opt;
+        size_t budget = 0;
+        size_t loaded_bytes = 0;
+        uint64_t loads = 0;
+        uint64_t evictions = 0;
+        uint64_t generations = 0;
+        std::map<std::string, Entry> entries;
+        std::list<std::string> lru; // loaded languages, most recently used first
+    };
+
+} // namespace LiteOCR
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "LiteOCREngine.h"
+#include "CountingAllocator.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace LiteOCR {
+
+    // per request state, shared by every lane and model working on the request
+    struct RequestState {
+        int priority = 0;
+        // past the deadline the request is dropped, past the budget it stops and keeps what is done
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+        std::chrono::steady_clock::time_point budget_end = std::chrono::steady_clock::time_point::max();
+        CancelToken cancel;
+        std::atomic<int> status{static_cast<int>(RequestStatus::Ok)};
+        AllocationCounter allocations; // charged by the threads working in an AllocationScope on it
+        RequestAllocations* report = nullptr;
+        std::string language; // recognizer the lines are read with, empty for the default one
+
+        explicit RequestState(const RequestOption &req = RequestOption()) : priority(req.priority), cancel(req.cancel), report(req.allocations), language(req.language) {
+            auto now = std::chrono::steady_clock::now();
+            if (req.deadlineMs > 0) {
+                deadline = now + std::chrono::milliseconds(req.deadlineMs);
+            }
+            if (req.timeBudgetMs > 0) {
+                budget_end = now + std::chrono::milliseconds(req.timeBudgetMs);
+            }
+        }
+
+        // false if another reason was recorded first
+        bool set(RequestStatus s) {
+            int expected = static_cast<int>(RequestStatus::Ok);
+            return status.compare_exchange_strong(expected, static_cast<int>(s));
+        }
+
+        RequestStatus get() const {
+            return static_cast<RequestStatus>(status.load());
+        }
+
+        bool dropped() const {
+            return get() == RequestStatus::Dropped;
+        }
+
+        // copy the counts out to the caller once the request is complete
+        void reportAllocations() {
+            if (report) {
+                report->matAllocations = allocations.mat.load();
+                report->blobAllocations = allocations.blob.load();
+            }
+        }
+
+        // polled between units of work, true once the request should stop
+        bool stopped() {
+            if (status.load(std::memory_order_relaxed) != static_cast<int>(RequestStatus::Ok)) {
+                return true;
+            }
+            if (cancel.cancelled()) {
+                set(RequestStatus::Cancelled);
+                return true;
+            }
+            if (budget_end != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= budget_end) {
+                set(RequestStatus::TimedOut);
+                return true;
+            }
+            return false;
+        }
+    };
+
+} // namespace LiteOCR
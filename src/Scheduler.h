@@ -0,0 +1,120 @@
+#pragma once
+
+#include "LiteOCREngine.h"
+#include "Request.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <tuple>
+
+namespace LiteOCR {
+
+    // admission in front of the detector and recognizer stages. every detector call and every
+    // recognition batch takes a slot of its stage, waiters are served by priority, then deadline,
+    // then arrival, so urgent requests overtake bulk ones between two units of work
+    class Scheduler {
+    public:
+        enum Stage { Detect = 0, Recognize = 1 };
+
+        // concurrent units per stage, 0 means unlimited (only deadlines are enforced)
+        void setSlots(int slots) {
+            std::lock_guard<std::mutex> lock(mutex);
+            max_slots = std::max(0, slots);
+        }
+
+        // false once the request is past its deadline or stopped, it must not run the unit then
+        bool acquire(Stage stage, RequestState &req) {
+            auto start = std::chrono::steady_clock::now();
+            if (req.stopped()) {
+                return false;
+            }
+            if (start >= req.deadline) {
+                std::lock_guard<std::mutex> lock(mutex);
+                return drop(stage, req);
+            }
+
+            std::unique_lock<std::mutex> lock(mutex);
+            StageState &st = stages[stage];
+            Key key(-req.priority, req.deadline, next_seq++);
+            st.waiting.insert(key);
+            st.stats.maxQueueDepth = std::max(st.stats.maxQueueDepth, st.waiting.size());
+
+            bool admitted = false;
+            while (true) {
+                if ((max_slots == 0 || st.running < max_slots) && *st.waiting.begin() == key) {
+                    admitted = true;
+                    break;
+                }
+                auto now = std::chrono::steady_clock::now();
+                if (now >= req.deadline) {
+                    drop(stage, req);
+                    break;
+                }
+                if (req.stopped()) {
+                    break;
+                }
+                // wake up now and then, a cancelled request must leave the queue too
+                st.cv.wait_until(lock, std::min(req.deadline, now + std::chrono::milliseconds(10)));
+            }
+            st.waiting.erase(key);
+
+            if (!admitted) {
+                // the next waiter may be admissible now
+                st.cv.notify_all();
+                return false;
+            }
+
+            st.running++;
+            double waited = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            st.stats.admitted++;
+            st.stats.totalWaitMs += waited;
+            st.stats.maxWaitMs = std::max(st.stats.maxWaitMs, waited);
+            // more slots may be free for the next waiter
+            st.cv.notify_all();
+            return true;
+        }
+
+        void release(Stage stage) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stages[stage].running--;
+            }
+            stages[stage].cv.notify_all();
+        }
+
+        SchedulerStats::Stage stats(Stage stage) {
+            std::lock_guard<std::mutex> lock(mutex);
+            SchedulerStats::Stage stats = stages[stage].stats;
+            stats.queueDepth = stages[stage].waiting.size();
+            stats.running = stages[stage].running;
+            return stats;
+        }
+
+    private:
+        using Key = std::tuple<int, std::chrono::steady_clock::time_point, uint64_t>;
+
+        struct StageState {
+            std::set<Key> waiting;
+            int running = 0;
+            std::condition_variable cv;
+            SchedulerStats::Stage stats;
+        };
+
+        bool drop(Stage stage, RequestState &req) {
+            if (req.set(RequestStatus::Dropped)) {
+                stages[stage].stats.dropped++;
+            }
+            return false;
+        }
+
+        std::mutex mutex;
+        StageState stages[2];
+        int max_slots = 0;
+        uint64_t next_seq = 0;
+    };
+
+} // namespace LiteOCR
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LiteOCR {
+
+    class ThreadPool {
+    public:
+        explicit ThreadPool(int numThreads) {
+            for (int i = 0; i < numThreads; i++) {
+                workers.emplace_back([this]() { loop(); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            cv.notify_all();
+            for (auto& worker : workers) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int size() const { return static_cast<int>(workers.size()); }
+
+        void submit(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push_back(std::move(task));
+            }
+            cv.notify_one();
+        }
+
+        // run lane on up to `lanes` threads, the calling thread is always one of them.
+        // lanes still queued when the caller returns from its own lane are skipped,
+        // so lanes must pull their work from shared state, and nesting cannot deadlock
+        void runLanes(int lanes, const std::function<void()>& lane) {
+            struct State {
+                std::mutex mutex;
+                std::condition_variable cv;
+                int active = 0;
+                bool closed = false;
+            };
+            auto state = std::make_shared<State>();
+
+            for (int i = 1; i < lanes; i++) {
+                submit([state, &lane]() {
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (state->closed) return;
+                        state->active++;
+                    }
+                    lane();
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->active--;
+                    }
+                    state->cv.notify_all();
+                });
+            }
+
+            lane();
+
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->closed = true;
+            state->cv.wait(lock, [&state]() { return state->active == 0; });
+        }
+
+    private:
+        void loop() {
+            while (true) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                    if (tasks.empty()) return;
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool stopping = false;
+    };
+
+} // namespace LiteOCR
@@ -0,0 +1,218 @@
+#include "Bundle.h"
+#include "LiteOCREngine.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace LiteOCR {
+    bool ModelBundle::open(const char* path) {
+        entries = nullptr;
+        count = 0;
+        if (!file.open(path)) {
+            return false;
+        }
+        const unsigned char* base = file.data();
+        size_t size = file.size();
+        BundleHeader header;
+        if (size < sizeof(header)) {
+            fprintf(stderr, "[LiteOCR]%s is not a model bundle\n", path);
+            file.close();
+            return false;
+        }
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC)) != 0) {
+            fprintf(stderr, "[LiteOCR]%s is not a model bundle\n", path);
+            file.close();
+            return false;
+        }
+        if (header.version != BUNDLE_VERSION) {
+            fprintf(stderr, "[LiteOCR]Model bundle %s has version %u, expected %u\n", path, header.version, BUNDLE_VERSION);
+            file.close();
+            return false;
+        }
+        if (header.count > (size - sizeof(header)) / sizeof(BundleEntry)) {
+            fprintf(stderr, "[LiteOCR]Model bundle %s is truncated\n", path);
+            file.close();
+            return false;
+        }
+        // the index sits right after the header, which keeps it 8 byte aligned in the mapping
+        const BundleEntry* index = reinterpret_cast<const BundleEntry*>(base + sizeof(header));
+        for (uint32_t i = 0; i < header.count; i++) {
+            const BundleEntry& entry = index[i];
+            if (entry.name[sizeof(entry.name) - 1] != '\0' || entry.offset % 4 != 0
+                || entry.offset > size || entry.size > size - entry.offset) {
+                fprintf(stderr, "[LiteOCR]Model bundle %s has a broken entry %u\n", path, i);
+                file.close();
+                return false;
+            }
+        }
+        entries = index;
+        count = header.count;
+        return true;
+    }
+
+    const BundleEntry* ModelBundle::find(const char* name) const {
+        for (uint32_t i = 0; i < count; i++) {
+            if (strcmp(entries[i].name, name) == 0) {
+                return &entries[i];
+            }
+        }
+        return nullptr;
+    }
+
+    const unsigned char* ModelBundle::data(const char* name) const {
+        const BundleEntry* entry = find(name);
+        return entry ? file.data() + entry->offset : nullptr;
+    }
+
+    size_t ModelBundle::size(const char* name) const {
+        const BundleEntry* entry = find(name);
+        return entry ? static_cast<size_t>(entry->size) : 0;
+    }
+
+    const char* ModelBundle::param(const char* name) const {
+        const BundleEntry* entry = find(name);
+        if (!entry || entry->size == 0 || file.data()[entry->offset + entry->size - 1] != '\0') {
+            return nullptr;
+        }
+        return reinterpret_cast<const char*>(file.data() + entry->offset);
+    }
+
+    bool ModelBundle::vocab(const char* name, std::vector<std::string_view>& tokens) const {
+        const BundleEntry* entry = find(name);
+        if (!entry || entry->size < sizeof(uint32_t)) {
+            return false;
+        }
+        const unsigned char* p = file.data() + entry->offset;
+        uint32_t n;
+        memcpy(&n, p, sizeof(n));
+        if (n >= entry->size / sizeof(uint32_t) - 1) {
+            return false;
+        }
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(p + sizeof(uint32_t));
+        const char* text = reinterpret_cast<const char*>(offsets + n + 1);
+        size_t text_size = entry->size - (n + 2) * sizeof(uint32_t);
+        if (offsets[n] > text_size) {
+            return false;
+        }
+        tokens.clear();
+        tokens.reserve(n);
+        for (uint32_t i = 0; i < n; i++) {
+            if (offsets[i] > offsets[i + 1]) {
+                return false;
+            }
+            tokens.emplace_back(text + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        return true;
+    }
+
+    namespace {
+        struct PackEntry {
+            std::string name;
+            std::string data;
+        };
+
+        bool read_file(const char* path, std::string& data) {
+            std::ifstream ifs(path, std::ios::binary);
+            if (!ifs.is_open()) {
+                fprintf(stderr, "[LiteOCR]Failed to open %s\n", path);
+                return false;
+            }
+            std::ostringstream ss;
+            ss << ifs.rdbuf();
+            data = ss.str();
+            return true;
+        }
+
+        // split the same way loadModel reads a vocab file, one token per line
+        bool pack_vocab(const char* path, std::string& data) {
+            std::string text;
+            if (!read_file(path, text)) {
+                return false;
+            }
+            std::istringstream stream(text);
+            std::vector<uint32_t> offsets{0};
+            std::string tokens, line;
+            while (std::getline(stream, line)) {
+                tokens += line;
+                offsets.push_back(static_cast<uint32_t>(tokens.size()));
+            }
+            uint32_t n = static_cast<uint32_t>(offsets.size() - 1);
+            data.assign(reinterpret_cast<const char*>(&n), sizeof(n));
+            data.append(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+            data += tokens;
+            return true;
+        }
+    }
+
+    bool packBundle(const BundleFiles& files, const char* bundlePath) {
+        enum Kind { Param, Bin, Vocab };
+        const struct {
+            const char* name;
+            const char* path;
+            Kind kind;
+        } sources[] = {
+            {"det.param", files.detParam, Param}, {"det.bin", files.detBin, Bin},
+            {"rec.param", files.recParam, Param}, {"rec.bin", files.recBin, Bin},
+            {"rec.vocab", files.vocab, Vocab},
+            {"ori.param", files.oriParam, Param}, {"ori.bin", files.oriBin, Bin},
+            {"table_cnn.param", files.tableCnnParam, Param}, {"table_cnn.bin", files.tableCnnBin, Bin},
+            {"table_head.param", files.tableHeadParam, Param}, {"table_head.bin", files.tableHeadBin, Bin},
+            {"table.vocab", files.tableVocab, Vocab},
+        };
+
+        std::vector<PackEntry> entries;
+        for (const auto& source : sources) {
+            if (!source.path) {
+                continue;
+            }
+            PackEntry entry{source.name, {}};
+            bool ok = source.kind == Vocab ? pack_vocab(source.path, entry.data) : read_file(source.path, entry.data);
+            if (!ok) {
+                return false;
+            }
+            if (source.kind == Param) {
+                entry.data.push_back('\0');
+            }
+            entries.push_back(std::move(entry));
+        }
+
+        BundleHeader header;
+        memcpy(header.magic, BUNDLE_MAGIC, sizeof(BUNDLE_MAGIC));
+        header.version = BUNDLE_VERSION;
+        header.count = static_cast<uint32_t>(entries.size());
+
+        auto align = [](uint64_t offset) { return (offset + BUNDLE_ALIGN - 1) / BUNDLE_ALIGN * BUNDLE_ALIGN; };
+        std::vector<BundleEntry> index(entries.size());
+        uint64_t offset = align(sizeof(header) + index.size() * sizeof(BundleEntry));
+        for (size_t i = 0; i < entries.size(); i++) {
+            memset(index[i].name, 0, sizeof(index[i].name));
+            memcpy(index[i].name, entries[i].name.data(), entries[i].name.size());
+            index[i].offset = offset;
+            index[i].size = entries[i].data.size();
+            offset = align(offset + entries[i].data.size());
+        }
+
+        std::ofstream ofs(bundlePath, std::ios::binary | std::ios::trunc);
+        if (!ofs.is_open()) {
+            fprintf(stderr, "[LiteOCR]Failed to create %s\n", bundlePath);
+            return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        ofs.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(BundleEntry));
+        uint64_t written = sizeof(header) + index.size() * sizeof(BundleEntry);
+        const char zeros[BUNDLE_ALIGN] = {};
+        for (size_t i = 0; i < entries.size(); i++) {
+            ofs.write(zeros, index[i].offset - written);
+            ofs.write(entries[i].data.data(), entries[i].data.size());
+            written = index[i].offset + entries[i].data.size();
+        }
+        if (!ofs.good()) {
+            fprintf(stderr, "[LiteOCR]Failed to write %s\n", bundlePath);
+            return false;
+        }
+        return true;
+    }
+}
@@ -0,0 +1,215 @@
+#include "BaseInfer.h"
+
+#include <cfloat>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LITEOCR_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LITEOCR_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(LITEOCR_X86) && (defined(__GNUC__) || defined(__clang__))
+#define LITEOCR_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define LITEOCR_TARGET_AVX2
+#endif
+
+namespace LiteOCR {
+    namespace {
+        // lanes keep the first maximum they saw, the lowest index among equal lanes wins,
+        // which gives the same answer as a scalar scan with a strict compare
+        int reduce_lanes(const float* values, const int* indices, int lanes, float& max_value) {
+            int max_index = -1;
+            max_value = -FLT_MAX;
+            for (int k = 0; k < lanes; k++) {
+                if (values[k] > max_value || (values[k] == max_value && indices[k] < max_index)) {
+                    max_value = values[k];
+                    max_index = indices[k];
+                }
+            }
+            return max_index;
+        }
+
+        int argmax_scalar(const float* row, int n, float& max_value) {
+            int max_index = -1;
+            max_value = -FLT_MAX;
+            for (int j = 0; j < n; j++) {
+                if (row[j] > max_value) {
+                    max_value = row[j];
+                    max_index = j;
+                }
+            }
+            return max_index;
+        }
+
+#if defined(LITEOCR_X86)
+        int argmax_sse2(const float* row, int n, float& max_value) {
+            if (n < 8) {
+                return argmax_scalar(row, n, max_value);
+            }
+
+            __m128 vmax = _mm_loadu_ps(row);
+            __m128i vidx = _mm_setr_epi32(0, 1, 2, 3);
+            __m128i cur = vidx;
+            const __m128i step = _mm_set1_epi32(4);
+            int j = 4;
+            for (; j + 4 <= n; j += 4) {
+                cur = _mm_add_epi32(cur, step);
+                __m128 v = _mm_loadu_ps(row + j);
+                __m128 gt = _mm_cmpgt_ps(v, vmax);
+                __m128i gti = _mm_castps_si128(gt);
+                vmax = _mm_or_ps(_mm_and_ps(gt, v), _mm_andnot_ps(gt, vmax));
+                vidx = _mm_or_si128(_mm_and_si128(gti, cur), _mm_andnot_si128(gti, vidx));
+            }
+
+            alignas(16) float values[4];
+            alignas(16) int indices[4];
+            _mm_store_ps(values, vmax);
+            _mm_store_si128(reinterpret_cast<__m128i*>(indices), vidx);
+            int max_index = reduce_lanes(values, indices, 4, max_value);
+            for (; j < n; j++) {
+                if (row[j] > max_value) {
+                    max_value = row[j];
+                    max_index = j;
+                }
+            }
+            return max_index;
+        }
+
+        LITEOCR_TARGET_AVX2 int argmax_avx2(const float* row, int n, float& max_value) {
+            if (n < 16) {
+                return argmax_scalar(row, n, max_value);
+            }
+
+            // two independent chains hide the compare/blend latency
+            __m256 vmax0 = _mm256_loadu_ps(row);
+            __m256 vmax1 = _mm256_loadu_ps(row + 8);
+            __m256i vidx0 = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+            __m256i vidx1 = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+            __m256i cur0 = vidx0;
+            __m256i cur1 = vidx1;
+            const __m256i step = _mm256_set1_epi32(16);
+            int j = 16;
+            for (; j + 16 <= n; j += 16) {
+                cur0 = _mm256_add_epi32(cur0, step);
+                cur1 = _mm256_add_epi32(cur1, step);
+                __m256 v0 = _mm256_loadu_ps(row + j);
+                __m256 v1 = _mm256_loadu_ps(row + j + 8);
+                __m256 gt0 = _mm256_cmp_ps(v0, vmax0, _CMP_GT_OQ);
+                __m256 gt1 = _mm256_cmp_ps(v1, vmax1, _CMP_GT_OQ);
+                vmax0 = _mm256_blendv_ps(vmax0, v0, gt0);
+                vmax1 = _mm256_blendv_ps(vmax1, v1, gt1);
+                vidx0 = _mm256_blendv_epi8(vidx0, cur0, _mm256_castps_si256(gt0));
+                vidx1 = _mm256_blendv_epi8(vidx1, cur1, _mm256_castps_si256(gt1));
+            }
+
+            alignas(32) float values[16];
+            alignas(32) int indices[16];
+            _mm256_store_ps(values, vmax0);
+            _mm256_store_ps(values + 8, vmax1);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(indices), vidx0);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(indices + 8), vidx1);
+            int max_index = reduce_lanes(values, indices, 16, max_value);
+            for (; j < n; j++) {
+                if (row[j] > max_value) {
+                    max_value = row[j];
+                    max_index = j;
+                }
+            }
+            return max_index;
+        }
+
+        bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7) return false;
+            __cpuid(info, 1);
+            // the os must save ymm registers too
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) return false;
+            __cpuidex(info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return __builtin_cpu_supports("avx2");
+#endif
+        }
+#endif
+
+#if defined(LITEOCR_NEON)
+        int argmax_neon(const float* row, int n, float& max_value) {
+            if (n < 8) {
+                return argmax_scalar(row, n, max_value);
+            }
+
+            float32x4_t vmax = vld1q_f32(row);
+            const uint32_t init[4] = {0, 1, 2, 3};
+            uint32x4_t vidx = vld1q_u32(init);
+            uint32x4_t cur = vidx;
+            const uint32x4_t step = vdupq_n_u32(4);
+            int j = 4;
+            for (; j + 4 <= n; j += 4) {
+                cur = vaddq_u32(cur, step);
+                float32x4_t v = vld1q_f32(row + j);
+                uint32x4_t gt = vcgtq_f32(v, vmax);
+                vmax = vbslq_f32(gt, v, vmax);
+                vidx = vbslq_u32(gt, cur, vidx);
+            }
+
+            float values[4];
+            int indices[4];
+            vst1q_f32(values, vmax);
+            vst1q_u32(reinterpret_cast<uint32_t*>(indices), vidx);
+            int max_index = reduce_lanes(values, indices, 4, max_value);
+            for (; j < n; j++) {
+                if (row[j] > max_value) {
+                    max_value = row[j];
+                    max_index = j;
+                }
+            }
+            return max_index;
+        }
+#endif
+
+        using ArgmaxFn = int (*)(const float*, int, float&);
+
+        ArgmaxFn select_argmax() {
+#if defined(LITEOCR_X86)
+            if (cpu_has_avx2()) {
+                return argmax_avx2;
+            }
+            return argmax_sse2;
+#elif defined(LITEOCR_NEON)
+            return argmax_neon;
+#else
+            return argmax_scalar;
+#endif
+        }
+    }
+
+    int CTCDecoder::argmax(const float* row, int n, float& max_value) {
+        static const ArgmaxFn fn = select_argmax();
+        return fn(row, n, max_value);
+    }
+
+    std::vector<std::tuple<int, float, int>> CTCDecoder::decode(const cv::Mat& probs, int blank_index) {
+        std::vector<std::tuple<int, float, int>> result;
+        int prev_index = -1;
+        for (int i = 0; i < probs.rows; i++) {
+            float max_value;
+            int max_index = argmax(probs.ptr<float>(i), probs.cols, max_value);
+            // skip if blank or same as previous
+            if (max_index != blank_index && max_index != prev_index) {
+                result.push_back(std::make_tuple(max_index, max_value, i));
+            }
+            prev_index = max_index;
+        }
+        return result;
+    }
+}
@@ -0,0 +1,40 @@
+#include "CountingAllocator.h"
+
+#include <mutex>
+
+namespace LiteOCR {
+    namespace {
+        // buffers are freed by the standard allocator directly, it is the one recorded in UMatData
+        class CountingMatAllocator : public cv::MatAllocator {
+        public:
+            cv::UMatData* allocate(int dims, const int* sizes, int type, void* data, size_t* step,
+                                   cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+                if (!data) {
+                    if (AllocationCounter* counter = AllocationScope::current()) {
+                        counter->mat++;
+                    }
+                }
+                return std_allocator->allocate(dims, sizes, type, data, step, flags, usageFlags);
+            }
+
+            bool allocate(cv::UMatData* data, cv::AccessFlag flags, cv::UMatUsageFlags usageFlags) const override {
+                return std_allocator->allocate(data, flags, usageFlags);
+            }
+
+            void deallocate(cv::UMatData* data) const override {
+                std_allocator->deallocate(data);
+            }
+
+        private:
+            cv::MatAllocator* std_allocator = cv::Mat::getStdAllocator();
+        };
+    }
+
+    void install_counting_mat_allocator() {
+        static CountingMatAllocator allocator;
+        static std::once_flag once;
+        std::call_once(once, []() {
+            cv::Mat::setDefaultAllocator(&allocator);
+        });
+    }
+}
@@ -0,0 +1,163 @@
+#include "BaseInfer.h"
+#include "ThreadPool.h"
+#include "opencv2/core/mat.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace LiteOCR {
+    // mean of pred inside the filled contour, the mask is drawn into buf which grows to the
+    // largest bounding box seen and is reused for every contour after that
+    static float contour_score(const cv::Mat& pred, const std::vector<cv::Point>& contour, std::vector<unsigned char>& buf) {
+        cv::Rect rect = cv::boundingRect(contour) & cv::Rect(0, 0, pred.cols, pred.rows);
+        size_t area = static_cast<size_t>(rect.area());
+        if (buf.size() < area) {
+            buf.resize(area);
+        }
+        cv::Mat mask(rect.height, rect.width, CV_8U, buf.data());
+        mask.setTo(0);
+        const cv::Point* pts = contour.data();
+        int npts = static_cast<int>(contour.size());
+        cv::fillPoly(mask, &pts, &npts, 1, cv::Scalar(1), cv::LINE_8, 0, cv::Point(-rect.x, -rect.y));
+        return static_cast<float>(cv::mean(pred(rect), mask).val[0]);
+    }
+
+    bool DBPostProcess::normalizeBox(cv::RotatedRect& box) {
+        int orientation = 0;
+
+        if (box.angle >= -30 && box.angle <= 30 && box.size.height > box.size.width * 2.7)
+        {
+            // vertical text
+            orientation = 1;
+        }
+        if ((box.angle <= -60 || box.angle >= 60) && box.size.width > box.size.height * 2.7)
+        {
+            // vertical text
+            orientation = 1;
+        }
+
+        if (box.angle < -30)
+        {
+            // make orientation from -90 ~ -30 to 90 ~ 150
+            box.angle += 180;
+        }
+        if (orientation == 0 && box.angle < 30)
+        {
+            // make it horizontal
+            box.angle += 90;
+            std::swap(box.size.width, box.size.height);
+        }
+        if (orientation == 1 && box.angle >= 60)
+        {
+            // make it vertical
+            box.angle -= 90;
+            std::swap(box.size.width, box.size.height);
+        }
+
+        return orientation == 1;
+    }
+
+    TextBox DBPostProcess::toTextBox(const cv::RotatedRect& box, bool vertical, float score) {
+        return TextBox{
+            .box = TextBox::RotatedRect{
+                .center = TextBox::RotatedRect::Point{box.center.x, box.center.y},
+                .size = TextBox::RotatedRect::Size{box.size.width, box.size.height},
+                .angle = box.angle
+            },
+            .isVertical = vertical,
+            .score = score
+        };
+    }
+
+    std::vector<TextBox> DBPostProcess::process(const cv::Mat& pred, float scale_x, float scale_y, float offset_x, float offset_y,
+                                                std::vector<cv::Rect2f>* rejected, ThreadPool* pool, ExecContext* ctx) const {
+        ScratchBuffers local;
+        ScratchBuffers& scratch = ctx ? ctx->scratch : local;
+        RequestState* request = ctx ? ctx->request : nullptr;
+
+        // text regions are smooth blobs, a smaller map keeps their shape at a fraction of the cost
+        cv::Mat map = pred;
+        if (downscale > 1 && pred.cols >= downscale * 8 && pred.rows >= downscale * 8) {
+            cv::resize(pred, scratch.map, cv::Size(pred.cols / downscale, pred.rows / downscale), 0, 0, cv::INTER_AREA);
+            map = scratch.map;
+            scale_x *= static_cast<float>(pred.cols) / map.cols;
+            scale_y *= static_cast<float>(pred.rows) / map.rows;
+        }
+
+        bool rescale = scale_x != 1.f || scale_y != 1.f;
+
+        // same as threshold + convertTo, in one pass
+        cv::Mat& binary = scratch.binary;
+        cv::compare(map, threshold, binary, cv::CMP_GT);
+
+        // hole contours are candidates too, they take part in the max_candidates cut
+        std::vector<std::vector<cv::Point>>& contours = scratch.contours;
+        cv::findContours(binary, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+        contours.resize(std::min(contours.size(), (size_t)max_candidates));
+
+        int count = static_cast<int>(contours.size());
+        std::vector<TextBox> candidates(count);
+        std::vector<char> accepted(count, 0);
+
+        std::vector<char> visited(count, 0);
+        auto fit = [&](int i, std::vector<unsigned char>& mask) {
+            if (request && request->stopped()) return;
+            visited[i] = 1;
+            const auto& contour = contours[i];
+            float score = contour.size() < 4 ? 0.f : contour_score(map, contour, mask);
+            if (score < box_threshold) return;
+
+            cv::RotatedRect box;
+            if (rescale) {
+                std::vector<cv::Point2f> points(contour.size());
+                for (size_t k = 0; k < contour.size(); k++) {
+                    points[k] = cv::Point2f((contour[k].x + 0.5f) * scale_x - 0.5f + offset_x, (contour[k].y + 0.5f) * scale_y - 0.5f + offset_y);
+                }
+                box = cv::minAreaRect(points);
+            } else {
+                box = cv::minAreaRect(contour);
+                box.center.x += offset_x;
+                box.center.y += offset_y;
+            }
+
+            bool vertical = normalizeBox(box);
+
+            // enlarge
+            box.size.height += box.size.width * (unclip_ratio - 1);
+            box.size.width *= unclip_ratio;
+
+            candidates[i] = toTextBox(box, vertical, score);
+            accepted[i] = 1;
+        };
+
+        // box fitting is independent per candidate, small pages are not worth the hand-off
+        const int min_parallel = 64;
+        if (pool && count >= min_parallel) {
+            std::atomic<int> next(0);
+            pool->runLanes(pool->size() + 1, [&]() {
+                std::vector<unsigned char> mask;
+                for (int i = next++; i < count; i = next++) {
+                    fit(i, mask);
+                }
+            });
+        } else {
+            for (int i = 0; i < count; i++) {
+                fit(i, scratch.mask);
+            }
+        }
+
+        std::vector<TextBox> textBoxes;
+        for (int i = 0; i < count; i++) {
+            if (accepted[i]) {
+                textBoxes.push_back(candidates[i]);
+            } else if (rejected && visited[i]) {
+                cv::Rect rect = cv::boundingRect(contours[i]);
+                rejected->push_back(cv::Rect2f(rect.x * scale_x + offset_x, rect.y * scale_y + offset_y,
+                                               rect.width * scale_x, rect.height * scale_y));
+            }
+        }
+        return textBoxes;
+    }
+}
@@ -0,0 +1,68 @@
+#include "BaseInfer.h"
+#include "opencv2/imgcodecs.hpp"
+
+namespace LiteOCR {
+    cv::Mat decode_image(const unsigned char* data, int size, int reduction) {
+        if (!data || size <= 0) {
+            return cv::Mat();
+        }
+        // imdecode only reads the buffer, the header never owns or changes it
+        cv::Mat buffer(1, size, CV_8UC1, const_cast<unsigned char*>(data));
+        int flags = cv::IMREAD_COLOR;
+        if (reduction == 2) {
+            flags = cv::IMREAD_REDUCED_COLOR_2;
+        } else if (reduction == 4) {
+            flags = cv::IMREAD_REDUCED_COLOR_4;
+        } else if (reduction == 8) {
+            flags = cv::IMREAD_REDUCED_COLOR_8;
+        }
+        return cv::imdecode(buffer, flags);
+    }
+
+    bool jpeg_size(const unsigned char* data, int size, int& width, int& height) {
+        if (!data || size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+            return false;
+        }
+        int pos = 2;
+        while (pos + 4 <= size) {
+            if (data[pos] != 0xFF) {
+                return false;
+            }
+            int marker = data[pos + 1];
+            if (marker == 0xFF) {
+                // fill byte
+                pos++;
+                continue;
+            }
+            pos += 2;
+            if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+                // no payload
+                continue;
+            }
+            int length = (data[pos] << 8) | data[pos + 1];
+            // every SOFn except DHT, JPG and DAC
+            if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+                if (pos + 7 > size) {
+                    return false;
+                }
+                height = (data[pos + 3] << 8) | data[pos + 4];
+                width = (data[pos + 5] << 8) | data[pos + 6];
+                return width > 0 && height > 0;
+            }
+            if (marker == 0xDA || length < 2) {
+                // scan data before any frame header
+                return false;
+            }
+            pos += length;
+        }
+        return false;
+    }
+
+    int decode_reduction(double factor) {
+        int reduction = 1;
+        while (reduction < 8 && reduction * 2 <= factor) {
+            reduction *= 2;
+        }
+        return reduction;
+    }
+}
@@ -133,8 +133,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet CNN param file from %s\n", cnnParamPath);
             return false;
         }
-        ret = cnnModel.load_model(cnnBinPath);
-        if (ret == -1) {
+        if (!load_weights(cnnModel, cnnBinPath, cnnWeights, opt)) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet CNN bin file from %s\n", cnnBinPath);
             return false;
         }
@@ -143,8 +142,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet SLA-Head param file from %s\n", slaheadParamPath);
             return false;
         }
-        ret = slaheadModel.load_model(slaheadBinPath);
-        if (ret == -1) {
+        if (!load_weights(slaheadModel, slaheadBinPath, slaheadWeights, opt)) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet SLA-Head bin file from %s\n", slaheadBinPath);
             return false;
         }
@@ -167,6 +165,20 @@ namespace LiteOCR {
                                            const char* slaheadParamBuffer, const unsigned char* slaheadBinBuffer,
                                            const char* vocabBuffer,
                                            const InferOption &opt) {
+        // load vocab from buffer
+        std::vector<std::string> tokens;
+        std::istringstream vocabStream(vocabBuffer);
+        std::string line;
+        while (std::getline(vocabStream, line)) {
+            tokens.push_back(line);
+        }
+        return loadModelFromBuffer(cnnParamBuffer, cnnBinBuffer, slaheadParamBuffer, slaheadBinBuffer, std::move(tokens), opt);
+    }
+
+    bool PaddleSLANet::loadModelFromBuffer(const char* cnnParamBuffer, const unsigned char* cnnBinBuffer,
+                                           const char* slaheadParamBuffer, const unsigned char* slaheadBinBuffer,
+                                           std::vector<std::string> tokens,
+                                           const InferOption &opt) {
         if (opt.gpuDeviceId != -1) {
             if (ncnn::get_gpu_count() <= 0) {
                 fprintf(stderr, "[LiteOCR]Your Device don`t have any vulkan device. Switch to cpu mode\n");
@@ -203,8 +215,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet CNN param from buffer\n");
             return false;
         }
-        ret = cnnModel.load_model(cnnBinBuffer);
-        if (ret == -1) {
+        if (cnnModel.load_model(cnnBinBuffer) == 0) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet CNN bin from buffer\n");
             return false;
         }
@@ -213,27 +224,25 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet SLA-Head param from buffer\n");
             return false;
         }
-        ret = slaheadModel.load_model(slaheadBinBuffer);
-        if (ret == -1) {
+        if (slaheadModel.load_model(slaheadBinBuffer) == 0) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleSLANet SLA-Head bin from buffer\n");
             return false;
         }
 
-        // load vocab from buffer
-        vocab.clear();
-        std::istringstream vocabStream(vocabBuffer);
-        std::string line;
-        while (std::getline(vocabStream, line)) {
-            vocab.push_back(line);
-        }
+        vocab = std::move(tokens);
         return true;
     }
 
-    std::vector<std::pair<std::string,std::array<float,8>>> PaddleSLANet::forward(const cv::Mat& input) {
+    std::vector<std::pair<std::string,std::array<float,8>>> PaddleSLANet::forward(const cv::Mat& input, ExecContext* ctx) {
+        if (stop_requested(ctx)) {
+            return {};
+        }
+
         ncnn::Mat in = ncnn::Mat::from_pixels_resize(input.data, ncnn::Mat::PIXEL_BGR, input.cols, input.rows, target_size, target_size);
         in.substract_mean_normalize(mean_vals, norm_vals);
 
         auto ex = cnnModel.create_extractor();
+        setup_extractor(ex, ctx);
         ex.input("in0", in);
         ncnn::Mat feat;
         ex.extract("out0", feat);
@@ -253,17 +262,22 @@ namespace LiteOCR {
         std::vector<std::pair<std::string, std::array<float, 8>>> result;
 
         while (step < max_step) {
+            if (stop_requested(ctx)) break;
+
+            // per step copies come from the context pools, they have the same size every step
+            ncnn::Allocator* alloc = ctx ? &ctx->blobAllocator : nullptr;
             auto ex2 = slaheadModel.create_extractor();
-            ex2.input("in0", hidden.clone());
-            ex2.input("in1", feat.clone());
-            ex2.input("in2", one_hot_feat.clone());
+            setup_extractor(ex2, ctx);
+            ex2.input("in0", hidden.clone(alloc));
+            ex2.input("in1", feat.clone(alloc));
+            ex2.input("in2", one_hot_feat.clone(alloc));
 
             ncnn::Mat hidden2, structure, loc;
             ex2.extract("out0", hidden2);
             ex2.extract("out1", structure);
             ex2.extract("out2", loc);
 
-            hidden = hidden2.clone();
+            hidden = hidden2.clone(alloc);
 
             int token = 0;
             float max_score = -1e30;
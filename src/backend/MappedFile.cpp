@@ -0,0 +1,125 @@
+#include "MappedFile.h"
+#include "BaseInfer.h"
+
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace LiteOCR {
+    MappedFile::MappedFile(MappedFile&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+        if (this != &other) {
+            close();
+            std::swap(addr, other.addr);
+            std::swap(length, other.length);
+#ifdef _WIN32
+            std::swap(mapping, other.mapping);
+#endif
+        }
+        return *this;
+    }
+
+#ifdef _WIN32
+    bool MappedFile::open(const char* path) {
+        close();
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            fprintf(stderr, "[LiteOCR]Failed to open %s for mapping\n", path);
+            return false;
+        }
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+            CloseHandle(file);
+            fprintf(stderr, "[LiteOCR]Failed to map %s, empty file\n", path);
+            return false;
+        }
+        // the mapping object keeps the file open, the handle is not needed past here
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) {
+            fprintf(stderr, "[LiteOCR]Failed to map %s\n", path);
+            return false;
+        }
+        addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!addr) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            fprintf(stderr, "[LiteOCR]Failed to map %s\n", path);
+            return false;
+        }
+        length = static_cast<size_t>(file_size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (addr) {
+            UnmapViewOfFile(addr);
+        }
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        addr = nullptr;
+        mapping = nullptr;
+        length = 0;
+    }
+#else
+    bool MappedFile::open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, "[LiteOCR]Failed to open %s for mapping\n", path);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            fprintf(stderr, "[LiteOCR]Failed to map %s, empty file\n", path);
+            return false;
+        }
+        // the mapping holds its own reference to the file
+        void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            fprintf(stderr, "[LiteOCR]Failed to map %s\n", path);
+            return false;
+        }
+        addr = mapped;
+        length = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    void MappedFile::close() {
+        if (addr) {
+            munmap(addr, length);
+        }
+        addr = nullptr;
+        length = 0;
+    }
+#endif
+
+    bool load_weights(ncnn::Net& net, const char* binPath, MappedFile& weights, const InferOption& opt) {
+        // load_param already dropped the layers of any previous load, its mapping can go
+        if (!opt.useMmap) {
+            weights.close();
+            return net.load_model(binPath) != -1;
+        }
+        if (!weights.open(binPath)) {
+            return false;
+        }
+        // page aligned, ncnn only needs 4 byte alignment. layers that repack their weights
+        // (fp16 storage, packed layouts, gpu upload) still make their own copy
+        size_t consumed = net.load_model(weights.data());
+        return consumed != 0;
+    }
+}
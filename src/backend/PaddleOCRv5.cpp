@@ -5,8 +5,15 @@
 #include <ncnn/gpu.h>
 #include <ncnn/mat.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 namespace LiteOCR {
     bool PaddleDetector::loadModel(const char* paramPath, const char* binPath, const InferOption &opt) {
+        limit_side_len = opt.detLimitSideLen;
+        max_pixels = opt.detMaxPixels;
+
         if (opt.gpuDeviceId != -1) {
             if (ncnn::get_gpu_count() <= 0) {
                 fprintf(stderr, "[LiteOCR]Your Device don`t have any vulkan device. Switch to cpu mode\n");
@@ -33,8 +40,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 param file from %s\n", paramPath);
             return false;
         }
-        ret = model.load_model(binPath);
-        if (ret == -1) {
+        if (!load_weights(model, binPath, weights, opt)) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 bin file from %s\n", binPath);
             return false;
         }
@@ -42,6 +48,9 @@ namespace LiteOCR {
     }
 
     bool PaddleDetector::loadModelFromBuffer(const char *paramBuffer, const unsigned char *binBuffer, const InferOption &opt) {
+        limit_side_len = opt.detLimitSideLen;
+        max_pixels = opt.detMaxPixels;
+
         if (opt.gpuDeviceId != -1) {
             if (ncnn::get_gpu_count() <= 0) {
                 fprintf(stderr, "[LiteOCR]Your Device don`t have any vulkan device. Switch to cpu mode\n");
@@ -68,34 +77,58 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 param from buffer\n");
             return false;
         }
-        ret = model.load_model(paramBuffer);
-        if (ret == -1) {
+        // the bin buffer is read in place, it must outlive the model
+        if (model.load_model(binBuffer) == 0) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 bin from buffer\n");
             return false;
         }
         return true;
     }
 
-    cv::Mat PaddleDetector::forward(const cv::Mat& input) {
-        ncnn::Mat in = ncnn::Mat::from_pixels(input.data, ncnn::Mat::PIXEL_BGR, input.cols, input.rows);
+    cv::Mat PaddleDetector::forward(const cv::Mat& input, ExecContext* ctx, PixelFormat format) {
+        float scale = 1.f;
+        if (limit_side_len > 0 && std::max(input.cols, input.rows) > limit_side_len) {
+            scale = static_cast<float>(limit_side_len) / std::max(input.cols, input.rows);
+        }
+        if (max_pixels > 0 && static_cast<double>(input.cols) * input.rows * scale * scale > max_pixels) {
+            scale = static_cast<float>(std::sqrt(static_cast<double>(max_pixels) / (static_cast<double>(input.cols) * input.rows)));
+        }
+
+        // input blobs come from the context pool as well
+        ncnn::Allocator* alloc = ctx ? &ctx->blobAllocator : nullptr;
+        ncnn::Mat in;
+        if (scale < 1.f) {
+            int target_width = std::max(1, static_cast<int>(input.cols * scale + 0.5f));
+            int target_height = std::max(1, static_cast<int>(input.rows * scale + 0.5f));
+            in = ncnn::Mat::from_pixels_resize(input.data, ncnn_bgr_type(format), input.cols, input.rows, static_cast<int>(input.step[0]), target_width, target_height, alloc);
+        } else {
+            in = ncnn::Mat::from_pixels(input.data, ncnn_bgr_type(format), input.cols, input.rows, static_cast<int>(input.step[0]), alloc);
+        }
         // pad to stride
         int w = in.w;;
         int h = in.h;
         int wpad = (w + stride - 1) / stride * stride - w;
         int hpad = (h + stride - 1) / stride * stride - h;
         ncnn::Mat in_pad;
-        ncnn::copy_make_border(in, in_pad, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, ncnn::BORDER_CONSTANT, 114.f);
+        ncnn::Option border_opt;
+        border_opt.blob_allocator = alloc;
+        ncnn::copy_make_border(in, in_pad, hpad / 2, hpad - hpad / 2, wpad / 2, wpad - wpad / 2, ncnn::BORDER_CONSTANT, 114.f, border_opt);
         in_pad.substract_mean_normalize(mean_vals, norm_vals);
 
         auto ex = model.create_extractor();
+        setup_extractor(ex, ctx);
         ex.input("in0", in_pad);
         ncnn::Mat out;
         ex.extract("out0", out);
         cv::Mat output(out.h, out.w, CV_32FC1, out.data);
 
-        // crop to original size
-        cv::Mat output_cropped = output(cv::Rect(wpad / 2, hpad / 2, w, h)).clone();
-        return output_cropped;
+        // crop to original size, with a context the crop stays a view into the padded output
+        cv::Mat output_cropped = output(cv::Rect(wpad / 2, hpad / 2, w, h));
+        if (ctx) {
+            ctx->detectorOutput = out;
+            return output_cropped;
+        }
+        return output_cropped.clone();
     }
 
     bool PaddleRecognizer::loadModel(const char* paramPath, const char* binPath, const InferOption &opt) {
@@ -125,8 +158,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 param file from %s\n", paramPath);
             return false;
         }
-        ret = model.load_model(binPath);
-        if (ret == -1) {
+        if (!load_weights(model, binPath, weights, opt)) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 bin file from %s\n", binPath);
             return false;
         }
@@ -160,19 +192,19 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 param from buffer\n");
             return false;
         }
-        ret = model.load_model(paramBuffer);
-        if (ret == -1) {
+        if (model.load_model(binBuffer) == 0) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleOCRv5 bin from buffer\n");
             return false;
         }
         return true;
     }
 
-    cv::Mat PaddleRecognizer::forward(const cv::Mat& input) {
+    cv::Mat PaddleRecognizer::forward(const cv::Mat& input, ExecContext* ctx) {
         int target_width = input.cols * target_height / input.rows;
         ncnn::Mat in = ncnn::Mat::from_pixels_resize(input.data, ncnn::Mat::PIXEL_BGR, input.cols, input.rows, target_width, target_height);
         in.substract_mean_normalize(mean_vals, norm_vals);
         auto ex = model.create_extractor();
+        setup_extractor(ex, ctx);
         ex.input("in0", in);
         ncnn::Mat out;
         ex.extract("out0", out);
@@ -180,27 +212,72 @@ namespace LiteOCR {
         return output.clone();
     }
 
-    std::vector<std::tuple<int, float, int>> CTCDecoder::decode(const cv::Mat& probs, int blank_index) {
-        std::vector<std::tuple<int, float, int>> result;
-        int prev_index = -1;
-        for (int i = 0; i < probs.rows; i++) {
-            // find max index
-            float max_value = -1e10;
-            int max_index = -1;
-            for (int j = 0; j < probs.cols; j++) {
-                float value = probs.at<float>(i, j);
-                if (value > max_value) {
-                    max_value = value;
-                    max_index = j;
-                }
-            }
-            // skip if blank or same as previous
-            if (max_index != blank_index && max_index != prev_index) {
-                result.push_back(std::make_tuple(max_index, max_value, i));
-            }
-            prev_index = max_index;
+    cv::Mat PaddleRecognizer::extract_line(ncnn::Extractor& ex, const ncnn::Mat& in, size_t index, ExecContext* ctx) {
+        ex.clear();
+        ex.input("in0", in);
+        ncnn::Mat out;
+        ex.extract("out0", out);
+        cv::Mat output(out.h, out.w, CV_32FC1, out.data);
+        if (!ctx) {
+            return output.clone();
+        }
+        // a view into the pooled blob, no copy per line
+        ctx->recognizerOutputs[index] = out;
+        return output;
+    }
+
+    std::vector<cv::Mat> PaddleRecognizer::forwardLines(const std::vector<cv::Mat>& inputs, ExecContext* ctx) {
+        std::vector<cv::Mat> outputs(inputs.size());
+        if (inputs.empty()) {
+            return outputs;
+        }
+
+        // the exported model has no batch axis and padding would change what a line reads,
+        // so every line runs at its own width through one extractor
+        ncnn::Allocator* alloc = ctx ? &ctx->blobAllocator : nullptr;
+        auto ex = model.create_extractor();
+        setup_extractor(ex, ctx);
+        if (ctx) {
+            ctx->recognizerOutputs.clear();
+            ctx->recognizerOutputs.resize(inputs.size());
+        }
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (stop_requested(ctx)) break;
+            const cv::Mat& input = inputs[i];
+            int target_width = std::max(1, input.cols * target_height / input.rows);
+            ncnn::Mat in = ncnn::Mat::from_pixels_resize(input.data, ncnn::Mat::PIXEL_BGR, input.cols, input.rows, static_cast<int>(input.step[0]), target_width, target_height, alloc);
+            in.substract_mean_normalize(mean_vals, norm_vals);
+            outputs[i] = extract_line(ex, in, i, ctx);
+        }
+        return outputs;
+    }
+
+    std::vector<cv::Mat> PaddleRecognizer::forwardCrops(const std::vector<TextlineCrop>& crops, ExecContext* ctx) {
+        std::vector<cv::Mat> outputs(crops.size());
+        if (crops.empty()) {
+            return outputs;
         }
-        return result;
+
+        // sample every line straight into the normalized input, no u8 crop and no second resize
+        ncnn::Allocator* alloc = ctx ? &ctx->blobAllocator : nullptr;
+        auto ex = model.create_extractor();
+        setup_extractor(ex, ctx);
+        if (ctx) {
+            ctx->recognizerOutputs.clear();
+            ctx->recognizerOutputs.resize(crops.size());
+        }
+        for (size_t i = 0; i < crops.size(); i++) {
+            // lines left after a stop keep an empty output
+            if (stop_requested(ctx)) break;
+            const TextlineCrop& crop = crops[i];
+            int target_width = std::max(1, crop.width * target_height / crop.height);
+            ncnn::Mat in(target_width, target_height, 3, 4u, alloc);
+            float m[6];
+            scale_crop(crop, static_cast<float>(crop.width) / target_width, static_cast<float>(crop.height) / target_height, m);
+            warp_affine_normalize(crop.image, crop.format, m, target_width, target_height, mean_vals, norm_vals, in, ctx);
+            outputs[i] = extract_line(ex, in, i, ctx);
+        }
+        return outputs;
     }
 
     bool PaddleTextlineORI::loadModel(const char* paramPath, const char* binPath, const InferOption &opt) {
@@ -230,8 +307,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleTextlineORI param file from %s\n", paramPath);
             return false;
         }
-        ret = model.load_model(binPath);
-        if (ret == -1) {
+        if (!load_weights(model, binPath, weights, opt)) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleTextlineORI bin file from %s\n", binPath);
             return false;
         }
@@ -265,25 +341,22 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleTextlineORI param from buffer\n");
             return false;
         }
-        ret = model.load_model(paramBuffer);
-        if (ret == -1) {
+        if (model.load_model(binBuffer) == 0) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleTextlineORI bin from buffer\n");
             return false;
         }
         return true;
     }
 
-    int PaddleTextlineORI::forward(const cv::Mat& input) {
-        constexpr float max_downscale = 3.0f;
-
+    int PaddleTextlineORI::forward(const cv::Mat& input, ExecContext* ctx) {
         float ratio = static_cast<float>(target_height) / static_cast<float>(input.rows);
         int rsz_w   = static_cast<int>(input.cols * ratio);
 
         cv::Mat rsz_image;
 
         if (rsz_w < target_width) {
-            cv::resize(input, rsz_image, cv::Size(target_width, target_height));
-            int pad_width = target_width - rsz_w;
+            cv::resize(input, rsz_image, cv::Size(std::max(rsz_w, 1), target_height));
+            int pad_width = target_width - rsz_image.cols;
             cv::copyMakeBorder(rsz_image, rsz_image, 0, 0, 0, pad_width,
                             cv::BORDER_CONSTANT, cv::Scalar(114.0, 114.0, 114.0));
         } else if (rsz_w < static_cast<int>(target_width * max_downscale)) {
@@ -300,12 +373,60 @@ namespace LiteOCR {
         in.substract_mean_normalize(mean_vals, norm_vals);
 
         auto ex = model.create_extractor();
+        setup_extractor(ex, ctx);
         ex.input("in0", in);
         ncnn::Mat out;
         ex.extract("out0", out);
 
         return out[0] > out[1] ? 0 : 1;
     }
+
+    std::vector<int> PaddleTextlineORI::forwardCrops(const std::vector<TextlineCrop>& crops, ExecContext* ctx) {
+        std::vector<int> labels(crops.size(), 0);
+        if (crops.empty()) {
+            return labels;
+        }
+
+        // same geometry as forward, sampled straight from the source image. one inference per
+        // crop: the model has no batch axis and its global pooling would mix stacked crops
+        ncnn::Mat in(target_width, target_height, 3, 4u, ctx ? &ctx->blobAllocator : nullptr);
+        auto ex = model.create_extractor();
+        setup_extractor(ex, ctx);
+        for (size_t i = 0; i < crops.size(); i++) {
+            if (stop_requested(ctx)) break;
+            const TextlineCrop& crop = crops[i];
+            float ratio = static_cast<float>(target_height) / static_cast<float>(crop.height);
+            int rsz_w = static_cast<int>(crop.width * ratio);
+
+            int src_w = crop.width;
+            int dst_w = target_width;
+            if (rsz_w < target_width) {
+                dst_w = std::max(rsz_w, 1);
+            } else if (rsz_w >= static_cast<int>(target_width * max_downscale)) {
+                src_w = std::min(static_cast<int>(max_downscale * target_width / ratio), crop.width);
+            }
+
+            float m[6];
+            scale_crop(crop, static_cast<float>(src_w) / dst_w, static_cast<float>(crop.height) / target_height, m);
+            warp_affine_normalize(crop.image, crop.format, m, dst_w, target_height, mean_vals, norm_vals, in, ctx);
+
+            for (int c = 0; c < 3; c++) {
+                float pad = (114.f - mean_vals[c]) * norm_vals[c];
+                for (int y = 0; y < target_height; y++) {
+                    float* row = in.channel(c).row(y);
+                    std::fill(row + dst_w, row + target_width, pad);
+                }
+            }
+
+            ex.clear();
+            ex.input("in0", in);
+            ncnn::Mat out;
+            ex.extract("out0", out);
+
+            labels[i] = out[0] > out[1] ? 0 : 1;
+        }
+        return labels;
+    }
     
     bool PaddleDocORI::loadModel(const char* paramPath, const char* binPath, const InferOption &opt) {
         if (opt.gpuDeviceId != -1) {
@@ -334,8 +455,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleDocORI param file from %s\n", paramPath);
             return false;
         }
-        ret = model.load_model(binPath);
-        if (ret == -1) {
+        if (!load_weights(model, binPath, weights, opt)) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleDocORI bin file from %s\n", binPath);
             return false;
         }
@@ -369,15 +489,14 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleDocORI param from buffer\n");
             return false;
         }
-        ret = model.load_model(paramBuffer);
-        if (ret == -1) {
+        if (model.load_model(binBuffer) == 0) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleDocORI bin from buffer\n");
             return false;
         }
         return true;
     }
 
-    int PaddleDocORI::forward(const cv::Mat& input) {
+    int PaddleDocORI::forward(const cv::Mat& input, ExecContext* ctx) {
         int target_size = 256; // short side resize to 256
         int target_width_resize = 0;
         int target_height_resize = 0;
@@ -400,6 +519,7 @@ namespace LiteOCR {
         ncnn::Mat in = ncnn::Mat::from_pixels_roi(resized.data, ncnn::Mat::PIXEL_BGR, resized.cols, resized.rows, x_start, y_start, target_width, target_height);
         in.substract_mean_normalize(mean_vals, norm_vals);
         auto ex = model.create_extractor();
+        setup_extractor(ex, ctx);
         ex.input("in0", in);
         ncnn::Mat out;
         ex.extract("out0", out);
@@ -0,0 +1,93 @@
+#include "PoolAllocator.h"
+#include "CountingAllocator.h"
+
+#include <cstdio>
+
+namespace LiteOCR {
+    CappedPoolAllocator::~CappedPoolAllocator() {
+        clear();
+        if (!payouts.empty()) {
+            fprintf(stderr, "[LiteOCR]%d blobs still in use when their allocator was destroyed\n", static_cast<int>(payouts.size()));
+        }
+    }
+
+    void CappedPoolAllocator::setCap(size_t bytes) {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (locked) lock.lock();
+        cap = bytes;
+        trim(cap);
+    }
+
+    void CappedPoolAllocator::setCounters(AllocatorCounters* counters_) {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (locked) lock.lock();
+        if (counters) counters->retainedBytes -= static_cast<int64_t>(retained);
+        counters = counters_;
+        if (counters) counters->retainedBytes += static_cast<int64_t>(retained);
+    }
+
+    void* CappedPoolAllocator::fastMalloc(size_t size) {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (locked) lock.lock();
+
+        // a free block which is big enough without wasting more than a quarter of it
+        for (auto it = budgets.begin(); it != budgets.end(); ++it) {
+            size_t bs = it->first;
+            if (bs >= size && bs / 4 * 3 <= size) {
+                void* ptr = it->second;
+                retained -= bs;
+                if (counters) {
+                    counters->pooledAllocations++;
+                    counters->retainedBytes -= static_cast<int64_t>(bs);
+                }
+                payouts.splice(payouts.end(), budgets, it);
+                return ptr;
+            }
+        }
+
+        void* ptr = ncnn::fastMalloc(size);
+        if (counters) counters->heapAllocations++;
+        if (AllocationCounter* counter = AllocationScope::current()) counter->blob++;
+        payouts.push_back(std::make_pair(size, ptr));
+        return ptr;
+    }
+
+    void CappedPoolAllocator::fastFree(void* ptr) {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (locked) lock.lock();
+
+        for (auto it = payouts.begin(); it != payouts.end(); ++it) {
+            if (it->second == ptr) {
+                size_t bs = it->first;
+                budgets.splice(budgets.end(), payouts, it);
+                retained += bs;
+                if (counters) counters->retainedBytes += static_cast<int64_t>(bs);
+                trim(cap);
+                return;
+            }
+        }
+
+        fprintf(stderr, "[LiteOCR]CappedPoolAllocator got a pointer it does not own\n");
+        ncnn::fastFree(ptr);
+    }
+
+    void CappedPoolAllocator::clear() {
+        std::unique_lock<std::mutex> lock(mutex, std::defer_lock);
+        if (locked) lock.lock();
+        trim(0);
+    }
+
+    void CappedPoolAllocator::trim(size_t cap_bytes) {
+        // least recently freed blocks go first
+        while (retained > cap_bytes && !budgets.empty()) {
+            auto& block = budgets.front();
+            ncnn::fastFree(block.second);
+            retained -= block.first;
+            if (counters) {
+                counters->released++;
+                counters->retainedBytes -= static_cast<int64_t>(block.first);
+            }
+            budgets.pop_front();
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#include "BaseInfer.h"
+#include "opencv2/core/mat.hpp"
+#include "opencv2/imgproc.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LITEOCR_X86 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define LITEOCR_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace LiteOCR {
+    namespace {
+        // one output plane of a row: the four taps of channel ch weighted, then * scale + bias.
+        // ofs holds the four taps of pixel x at x * 4, wts holds tap k of every pixel at k * width.
+        // the taps are gathered one byte at a time, the arithmetic runs four pixels at a time
+        void blend_plane(const unsigned char* data, const ptrdiff_t* ofs, const float* wts, int width, int ch,
+                         float scale, float bias, float* out) {
+            const float* k0 = wts;
+            const float* k1 = wts + width;
+            const float* k2 = wts + width * 2;
+            const float* k3 = wts + width * 3;
+            int x = 0;
+#if defined(LITEOCR_X86)
+            const __m128 vscale = _mm_set1_ps(scale);
+            const __m128 vbias = _mm_set1_ps(bias);
+            for (; x + 4 <= width; x += 4) {
+                const ptrdiff_t* o = ofs + x * 4;
+                __m128 t0 = _mm_setr_ps(data[o[0] + ch], data[o[4] + ch], data[o[8] + ch], data[o[12] + ch]);
+                __m128 t1 = _mm_setr_ps(data[o[1] + ch], data[o[5] + ch], data[o[9] + ch], data[o[13] + ch]);
+                __m128 t2 = _mm_setr_ps(data[o[2] + ch], data[o[6] + ch], data[o[10] + ch], data[o[14] + ch]);
+                __m128 t3 = _mm_setr_ps(data[o[3] + ch], data[o[7] + ch], data[o[11] + ch], data[o[15] + ch]);
+                __m128 v = _mm_mul_ps(t0, _mm_loadu_ps(k0 + x));
+                v = _mm_add_ps(v, _mm_mul_ps(t1, _mm_loadu_ps(k1 + x)));
+                v = _mm_add_ps(v, _mm_mul_ps(t2, _mm_loadu_ps(k2 + x)));
+                v = _mm_add_ps(v, _mm_mul_ps(t3, _mm_loadu_ps(k3 + x)));
+                _mm_storeu_ps(out + x, _mm_add_ps(_mm_mul_ps(v, vscale), vbias));
+            }
+#elif defined(LITEOCR_NEON)
+            const float32x4_t vscale = vdupq_n_f32(scale);
+            const float32x4_t vbias = vdupq_n_f32(bias);
+            for (; x + 4 <= width; x += 4) {
+                const ptrdiff_t* o = ofs + x * 4;
+                float taps[4][4];
+                for (int p = 0; p < 4; p++) {
+                    for (int k = 0; k < 4; k++) {
+                        taps[k][p] = data[o[p * 4 + k] + ch];
+                    }
+                }
+                float32x4_t v = vmulq_f32(vld1q_f32(taps[0]), vld1q_f32(k0 + x));
+                v = vaddq_f32(v, vmulq_f32(vld1q_f32(taps[1]), vld1q_f32(k1 + x)));
+                v = vaddq_f32(v, vmulq_f32(vld1q_f32(taps[2]), vld1q_f32(k2 + x)));
+                v = vaddq_f32(v, vmulq_f32(vld1q_f32(taps[3]), vld1q_f32(k3 + x)));
+                vst1q_f32(out + x, vaddq_f32(vmulq_f32(v, vscale), vbias));
+            }
+#endif
+            for (; x < width; x++) {
+                const ptrdiff_t* o = ofs + x * 4;
+                float v = data[o[0] + ch] * k0[x] + data[o[1] + ch] * k1[x] + data[o[2] + ch] * k2[x] + data[o[3] + ch] * k3[x];
+                out[x] = v * scale + bias;
+            }
+        }
+    }
+
+    void warp_affine_normalize(const cv::Mat& image, PixelFormat format, const float m[6], int width, int height,
+                               const float mean_vals[3], const float norm_vals[3], ncnn::Mat& dst, ExecContext* ctx) {
+        const int w = image.cols;
+        const int h = image.rows;
+        // byte offsets, an image can be larger than an int reaches
+        const ptrdiff_t step = static_cast<ptrdiff_t>(image.step[0]);
+        const unsigned char* data = image.data;
+        const int cn = pixel_channels(format);
+        // byte offsets of blue, green and red inside one pixel
+        const bool rgb = format == PixelFormat::RGB || format == PixelFormat::RGBA;
+        const int ib = cn == 1 ? 0 : (rgb ? 2 : 0);
+        const int ig = cn == 1 ? 0 : 1;
+        const int ir = cn == 1 ? 0 : (rgb ? 0 : 2);
+
+        // (v - mean) * norm folded into one multiply-add
+        const float scale[3] = {norm_vals[0], norm_vals[1], norm_vals[2]};
+        const float bias[3] = {-mean_vals[0] * norm_vals[0], -mean_vals[1] * norm_vals[1], -mean_vals[2] * norm_vals[2]};
+
+        // source offsets and weights of one row, reused by all three output planes
+        std::vector<ptrdiff_t> local_ofs;
+        std::vector<float> local_wts;
+        std::vector<ptrdiff_t>& ofs = ctx ? ctx->scratch.warpOffsets : local_ofs;
+        std::vector<float>& wts = ctx ? ctx->scratch.warpWeights : local_wts;
+        if (ofs.size() < static_cast<size_t>(width) * 4) {
+            ofs.resize(static_cast<size_t>(width) * 4);
+        }
+        if (wts.size() < static_cast<size_t>(width) * 4) {
+            wts.resize(static_cast<size_t>(width) * 4);
+        }
+
+        for (int y = 0; y < height; y++) {
+            float sx = m[1] * y + m[2];
+            float sy = m[4] * y + m[5];
+            for (int x = 0; x < width; x++, sx += m[0], sy += m[3]) {
+                float fx0 = std::floor(sx);
+                float fy0 = std::floor(sy);
+                float ax = sx - fx0;
+                float ay = sy - fy0;
+                // replicate border
+                int x0 = std::min(std::max(static_cast<int>(fx0), 0), w - 1);
+                int x1 = std::min(std::max(static_cast<int>(fx0) + 1, 0), w - 1);
+                int y0 = std::min(std::max(static_cast<int>(fy0), 0), h - 1);
+                int y1 = std::min(std::max(static_cast<int>(fy0) + 1, 0), h - 1);
+
+                ofs[x * 4 + 0] = y0 * step + static_cast<ptrdiff_t>(x0) * cn;
+                ofs[x * 4 + 1] = y0 * step + static_cast<ptrdiff_t>(x1) * cn;
+                ofs[x * 4 + 2] = y1 * step + static_cast<ptrdiff_t>(x0) * cn;
+                ofs[x * 4 + 3] = y1 * step + static_cast<ptrdiff_t>(x1) * cn;
+                wts[x] = (1.f - ax) * (1.f - ay);
+                wts[width + x] = ax * (1.f - ay);
+                wts[width * 2 + x] = (1.f - ax) * ay;
+                wts[width * 3 + x] = ax * ay;
+            }
+
+            blend_plane(data, ofs.data(), wts.data(), width, ib, scale[0], bias[0], dst.channel(0).row(y));
+            blend_plane(data, ofs.data(), wts.data(), width, ig, scale[1], bias[1], dst.channel(1).row(y));
+            blend_plane(data, ofs.data(), wts.data(), width, ir, scale[2], bias[2], dst.channel(2).row(y));
+        }
+    }
+
+    cv::Mat warp_crop(const TextlineCrop& crop) {
+        cv::Mat tm(2, 3, CV_32F, const_cast<float*>(crop.m));
+        cv::Mat dst;
+        cv::warpAffine(crop.image, dst, tm, cv::Size(crop.width, crop.height), cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_REPLICATE);
+        // only the small crop is converted, never the whole image
+        switch (crop.format) {
+            case PixelFormat::RGB: cv::cvtColor(dst, dst, cv::COLOR_RGB2BGR); break;
+            case PixelFormat::Gray: cv::cvtColor(dst, dst, cv::COLOR_GRAY2BGR); break;
+            case PixelFormat::BGRA: cv::cvtColor(dst, dst, cv::COLOR_BGRA2BGR); break;
+            case PixelFormat::RGBA: cv::cvtColor(dst, dst, cv::COLOR_RGBA2BGR); break;
+            default: break;
+        }
+        return dst;
+    }
+
+    void scale_crop(const TextlineCrop& crop, float scale_x, float scale_y, float m[6]) {
+        // x = (u + 0.5) * scale_x - 0.5, same for y
+        float ox = 0.5f * scale_x - 0.5f;
+        float oy = 0.5f * scale_y - 0.5f;
+        m[0] = crop.m[0] * scale_x;
+        m[1] = crop.m[1] * scale_y;
+        m[2] = crop.m[2] + crop.m[0] * ox + crop.m[1] * oy;
+        m[3] = crop.m[3] * scale_x;
+        m[4] = crop.m[4] * scale_y;
+        m[5] = crop.m[5] + crop.m[3] * ox + crop.m[4] * oy;
+    }
+
+    void rotate_crop_180(TextlineCrop& crop) {
+        // dst (x, y) now reads what dst (width - 1 - x, height - 1 - y) read before
+        float* m = crop.m;
+        m[2] += m[0] * (crop.width - 1) + m[1] * (crop.height - 1);
+        m[5] += m[3] * (crop.width - 1) + m[4] * (crop.height - 1);
+        m[0] = -m[0];
+        m[1] = -m[1];
+        m[3] = -m[3];
+        m[4] = -m[4];
+    }
+}
@@ -0,0 +1,200 @@
+#include "RecognizerRegistry.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace LiteOCR {
+    namespace {
+        size_t vocab_bytes(const RecognizerModel& model) {
+            return model.vocab.size() * sizeof(std::string_view) + model.vocab_text.size();
+        }
+    }
+
+    void set_vocab(RecognizerModel& model, std::string text) {
+        model.vocab_text = std::move(text);
+        model.vocab.clear();
+        std::string_view rest = model.vocab_text;
+        while (!rest.empty()) {
+            size_t end = rest.find('\n');
+            if (end == std::string_view::npos) {
+                end = rest.size();
+            }
+            model.vocab.push_back(rest.substr(0, end));
+            rest.remove_prefix(std::min(end + 1, rest.size()));
+        }
+    }
+
+    bool read_vocab(RecognizerModel& model, const char* vocabPath) {
+        std::ifstream vocabFile(vocabPath);
+        if (!vocabFile.is_open()) {
+            fprintf(stderr, "[LiteOCR]Failed to open vocab file from %s\n", vocabPath);
+            return false;
+        }
+        std::ostringstream text;
+        text << vocabFile.rdbuf();
+        set_vocab(model, text.str());
+        return true;
+    }
+
+    std::shared_ptr<RecognizerModel> load_recognizer(const char* paramPath, const char* binPath, const char* vocabPath, const InferOption& opt) {
+        auto model = std::make_shared<RecognizerModel>();
+        model->recognizer.reset(new PaddleRecognizer());
+        if (!model->recognizer->loadModel(paramPath, binPath, opt)) {
+            fprintf(stderr, "[LiteOCR]Failed to load recognizer model from %s and %s\n", paramPath, binPath);
+            return nullptr;
+        }
+        if (!read_vocab(*model, vocabPath)) {
+            return nullptr;
+        }
+        // fp32 weights take about what the file does once loaded
+        std::ifstream binFile(binPath, std::ios::binary | std::ios::ate);
+        model->bytes = static_cast<size_t>(std::max<std::streamoff>(0, binFile.tellg())) + vocab_bytes(*model);
+        return model;
+    }
+
+    std::shared_ptr<RecognizerModel> load_recognizer_bundle(const char* bundlePath, const InferOption& opt) {
+        auto model = std::make_shared<RecognizerModel>();
+        model->bundle = std::make_unique<ModelBundle>();
+        if (!model->bundle->open(bundlePath)) {
+            fprintf(stderr, "[LiteOCR]Failed to open model bundle %s\n", bundlePath);
+            return nullptr;
+        }
+        const char* param = model->bundle->param("rec.param");
+        const unsigned char* bin = model->bundle->data("rec.bin");
+        if (!param || !bin || !model->bundle->vocab("rec.vocab", model->vocab)) {
+            fprintf(stderr, "[LiteOCR]Model bundle %s has no recognizer and vocab\n", bundlePath);
+            return nullptr;
+        }
+        model->recognizer.reset(new PaddleRecognizer());
+        if (!model->recognizer->loadModelFromBuffer(param, bin, opt)) {
+            fprintf(stderr, "[LiteOCR]Failed to load recognizer model from %s\n", bundlePath);
+            return nullptr;
+        }
+        model->bytes = model->bundle->size("rec.bin") + model->bundle->size("rec.vocab") + vocab_bytes(*model);
+        return model;
+    }
+
+    void RecognizerRegistry::configure(const InferOption& opt, size_t budget) {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->opt = opt;
+        this->budget = budget;
+    }
+
+    void RecognizerRegistry::add(const std::string& language, const char* paramPath, const char* binPath, const char* vocabPath) {
+        std::lock_guard<std::mutex> lock(mutex);
+        unload(language);
+        Entry& entry = entries[language];
+        entry.paramPath = paramPath;
+        entry.binPath = binPath;
+        entry.vocabPath = vocabPath;
+        entry.bundlePath.clear();
+        entry.generation = ++generations;
+        if (!entry.loading) {
+            entry.loading = std::make_shared<std::mutex>();
+        }
+    }
+
+    void RecognizerRegistry::addBundle(const std::string& language, const char* bundlePath) {
+        std::lock_guard<std::mutex> lock(mutex);
+        unload(language);
+        Entry& entry = entries[language];
+        entry.paramPath.clear();
+        entry.binPath.clear();
+        entry.vocabPath.clear();
+        entry.bundlePath = bundlePath;
+        entry.generation = ++generations;
+        if (!entry.loading) {
+            entry.loading = std::make_shared<std::mutex>();
+        }
+    }
+
+    std::shared_ptr<const RecognizerModel> RecognizerRegistry::acquire(const std::string& language) {
+        std::shared_ptr<std::mutex> loading;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(language);
+            if (it == entries.end()) {
+                return nullptr;
+            }
+            if (it->second.model) {
+                lru.splice(lru.begin(), lru, std::find(lru.begin(), lru.end(), language));
+                return it->second.model;
+            }
+            loading = it->second.loading;
+        }
+
+        // callers of the same language wait here for the first one to load it
+        std::lock_guard<std::mutex> load_lock(*loading);
+        std::string paramPath, binPath, vocabPath, bundlePath;
+        uint64_t generation = 0;
+        InferOption load_opt;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = entries.find(language);
+            if (it == entries.end()) {
+                return nullptr;
+            }
+            if (it->second.model) {
+                lru.splice(lru.begin(), lru, std::find(lru.begin(), lru.end(), language));
+                return it->second.model;
+            }
+            paramPath = it->second.paramPath;
+            binPath = it->second.binPath;
+            vocabPath = it->second.vocabPath;
+            bundlePath = it->second.bundlePath;
+            generation = it->second.generation;
+            load_opt = opt;
+        }
+
+        std::shared_ptr<RecognizerModel> model = bundlePath.empty()
+            ? load_recognizer(paramPath.c_str(), binPath.c_str(), vocabPath.c_str(), load_opt)
+            : load_recognizer_bundle(bundlePath.c_str(), load_opt);
+        if (!model) {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(language);
+        if (it == entries.end() || it->second.generation != generation) {
+            // registered again while loading, this caller still reads with what it loaded
+            return model;
+        }
+        it->second.model = model;
+        lru.push_front(language);
+        loaded_bytes += model->bytes;
+        loads++;
+        evict();
+        return model;
+    }
+
+    RecognizerStats RecognizerRegistry::stats() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        RecognizerStats stats;
+        stats.loaded.assign(lru.begin(), lru.end());
+        stats.loadedBytes = loaded_bytes;
+        stats.loads = loads;
+        stats.evictions = evictions;
+        return stats;
+    }
+
+    void RecognizerRegistry::unload(const std::string& language) {
+        auto it = entries.find(language);
+        if (it == entries.end() || !it->second.model) {
+            return;
+        }
+        loaded_bytes -= it->second.model->bytes;
+        it->second.model.reset();
+        lru.remove(language);
+    }
+
+    // the model just loaded is at the front, it stays even when it alone is over the budget
+    void RecognizerRegistry::evict() {
+        while (budget > 0 && loaded_bytes > budget && lru.size() > 1) {
+            std::string victim = lru.back();
+            unload(victim);
+            evictions++;
+        }
+    }
+}
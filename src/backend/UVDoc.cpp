@@ -30,8 +30,7 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleUVDoc param file from %s\n", paramPath);
             return false;
         }
-        ret = model.load_model(binPath);
-        if (ret == -1) {
+        if (!load_weights(model, binPath, weights, opt)) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleUVDoc bin file from %s\n", binPath);
             return false;
         }
@@ -65,18 +64,18 @@ namespace LiteOCR {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleUVDoc param from buffer\n");
             return false;
         }
-        ret = model.load_model(binBuffer);
-        if (ret == -1) {
+        if (model.load_model(binBuffer) == 0) {
             fprintf(stderr, "[LiteOCR]Failed to load PaddleUVDoc bin from buffer\n");
             return false;
         }
         return true;
     }
 
-    cv::Mat PaddleUVDoc::forward(const cv::Mat& input) {
+    cv::Mat PaddleUVDoc::forward(const cv::Mat& input, ExecContext* ctx) {
         ncnn::Mat in = ncnn::Mat::from_pixels(input.data, ncnn::Mat::PIXEL_BGR2RGB, input.cols, input.rows);
         in.substract_mean_normalize(0, norm_vals);
         ncnn::Extractor ex = model.create_extractor();
+        setup_extractor(ex, ctx);
         ex.input("in0", in);
         ncnn::Mat out;
         ex.extract("out0", out);
@@ -0,0 +1,111 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+// text of every recognized line, one per row
+static std::string text_of(const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+    std::string text;
+    for (const auto& textline : result.second) {
+        text += textline.text + "\n";
+    }
+    return text;
+}
+
+static bool load(LiteOCR::LiteOCREngine& engine, const LiteOCR::InferOption& opt) {
+    return engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        nullptr, nullptr, opt
+    );
+}
+
+int main() {
+    const char* inputfile = "test2.png";
+    const int loops = 10;
+
+    auto ifs = std::ifstream(inputfile, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+    std::vector<unsigned char> imgData((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    int size = static_cast<int>(imgData.size());
+
+    // no pooling: every blob comes from the heap, against the default cap
+    LiteOCR::InferOption unpooled_opt;
+    unpooled_opt.poolCapMB = 0;
+    LiteOCR::InferOption pooled_opt;
+
+    LiteOCR::LiteOCREngine unpooled, pooled;
+    if (!load(unpooled, unpooled_opt) || !load(pooled, pooled_opt)) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+
+    auto bench = [&](LiteOCR::LiteOCREngine& engine, std::string& text) {
+        // first call warms the pools
+        text = text_of(engine.recognize(imgData.data(), size));
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < loops; i++) {
+            engine.recognize(imgData.data(), size);
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / loops;
+    };
+
+    std::string unpooled_text, pooled_text;
+    LiteOCR::AllocatorStats unpooled_before = unpooled.allocatorStats();
+    double unpooled_ms = bench(unpooled, unpooled_text);
+    LiteOCR::AllocatorStats unpooled_after = unpooled.allocatorStats();
+    LiteOCR::AllocatorStats pooled_before = pooled.allocatorStats();
+    double pooled_ms = bench(pooled, pooled_text);
+    LiteOCR::AllocatorStats pooled_after = pooled.allocatorStats();
+
+    auto report = [&](const char* name, double ms, const LiteOCR::AllocatorStats& before, const LiteOCR::AllocatorStats& after) {
+        std::cout << name << ms << " ms, "
+                  << (after.heapAllocations - before.heapAllocations) << " heap / "
+                  << (after.pooledAllocations - before.pooledAllocations) << " pooled blobs, "
+                  << (after.released - before.released) << " released, "
+                  << after.retainedBytes / 1024 << " KB retained" << std::endl;
+    };
+    report("unpooled : ", unpooled_ms, unpooled_before, unpooled_after);
+    report("pooled   : ", pooled_ms, pooled_before, pooled_after);
+
+    // same text either way, and the pooled engine needs far fewer heap blobs
+    bool same = unpooled_text == pooled_text;
+    bool fewer = pooled_after.heapAllocations - pooled_before.heapAllocations
+               < unpooled_after.heapAllocations - unpooled_before.heapAllocations;
+    bool capped = unpooled_after.retainedBytes == 0;
+    std::cout << "same text " << same << ", fewer heap allocations " << fewer << ", unpooled retains nothing " << capped << std::endl;
+
+    // per request counts, the first request fills the pools and scratch buffers, later ones reuse them
+    LiteOCR::InferOption counted_opt;
+    counted_opt.countAllocations = true;
+    LiteOCR::LiteOCREngine counted;
+    if (!load(counted, counted_opt)) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    cv::Mat image = cv::imdecode(imgData, cv::IMREAD_COLOR);
+    std::vector<LiteOCR::RequestAllocations> requests(4);
+    for (auto& allocations : requests) {
+        LiteOCR::RequestOption req;
+        req.allocations = &allocations;
+        counted.recognize(&image, req);
+    }
+    for (size_t i = 0; i < requests.size(); i++) {
+        std::cout << "request " << i << " : " << requests[i].matAllocations << " cv::Mat, "
+                  << requests[i].blobAllocations << " ncnn blob heap allocations" << std::endl;
+    }
+    bool steady = requests.back().matAllocations < requests.front().matAllocations
+               && requests.back().blobAllocations < requests.front().blobAllocations;
+    std::cout << "steady state allocates less " << steady << std::endl;
+    return same && fewer && capped && steady ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <thread>
+#include <vector>
+int main() {
+    const char* inputfile = "test2.png";
+    const int numRequests = 8;
+
+    LiteOCR::InferOption opt;
+    opt.numWorkers = 4;
+
+    LiteOCR::LiteOCREngine engine;
+    bool ok = engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        nullptr, nullptr,
+        opt
+    );
+    if (!ok) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+
+    auto ifs = std::ifstream(inputfile, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+    std::vector<unsigned char> imgData((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+
+    auto expected = engine.recognize(imgData.data(), static_cast<int>(imgData.size()));
+
+    auto same = [&expected](const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+        if (result.second.size() != expected.second.size()) return false;
+        for (size_t i = 0; i < result.second.size(); i++) {
+            if (result.second[i].text != expected.second[i].text) return false;
+        }
+        return true;
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>>> futures;
+    for (int i = 0; i < numRequests; i++) {
+        futures.push_back(engine.recognizeAsync(imgData.data(), static_cast<int>(imgData.size())));
+    }
+
+    std::atomic<int> callbacks(0), callback_mismatches(0);
+    for (int i = 0; i < numRequests; i++) {
+        engine.recognizeAsync(imgData.data(), static_cast<int>(imgData.size()),
+            [&](std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>> result) {
+                if (!same(result)) callback_mismatches++;
+                callbacks++;
+            });
+    }
+    auto submitted = std::chrono::steady_clock::now();
+
+    int mismatches = 0;
+    for (auto& future : futures) {
+        if (!same(future.get())) mismatches++;
+    }
+    while (callbacks < numRequests) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    std::cout << "submit   : " << std::chrono::duration<double, std::milli>(submitted - start).count() << " ms" << std::endl;
+    std::cout << "complete : " << std::chrono::duration<double, std::milli>(end - start).count() << " ms for "
+              << 2 * numRequests << " requests" << std::endl;
+    std::cout << mismatches + callback_mismatches << " mismatches" << std::endl;
+
+    return mismatches + callback_mismatches == 0 ? 0 : 1;
+}
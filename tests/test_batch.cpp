@@ -0,0 +1,110 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+int main() {
+    LiteOCR::InferOption opt;
+    opt.numWorkers = 4;
+
+    LiteOCR::LiteOCREngine engine;
+    bool ok = engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        nullptr, nullptr,
+        opt
+    );
+    if (!ok) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+
+    // many small crops of the test pages, like a stack of receipts
+    std::vector<cv::Mat> images;
+    for (const char* inputfile : {"test.png", "test2.png"}) {
+        cv::Mat page = cv::imread(inputfile, cv::IMREAD_COLOR);
+        if (page.empty()) {
+            std::cerr << "Failed to open image file: " << inputfile << std::endl;
+            return -1;
+        }
+        int step = std::max(1, page.rows / 8);
+        for (int y = 0; y + step <= page.rows; y += step) {
+            images.push_back(page(cv::Rect(0, y, page.cols, step)).clone());
+        }
+    }
+
+    std::vector<const void*> mats;
+    for (const auto& image : images) {
+        mats.push_back(&image);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>> single;
+    for (const auto& image : images) {
+        single.push_back(engine.recognize(&image));
+    }
+    auto mid = std::chrono::steady_clock::now();
+    auto batched = engine.recognizeBatch(mats);
+    auto end = std::chrono::steady_clock::now();
+
+    int lines = 0, mismatches = 0;
+    for (size_t i = 0; i < images.size(); i++) {
+        if (batched[i].second.size() != single[i].second.size()) {
+            mismatches++;
+            continue;
+        }
+        for (size_t j = 0; j < single[i].second.size(); j++) {
+            lines++;
+            if (batched[i].second[j].text != single[i].second[j].text) {
+                mismatches++;
+            }
+        }
+    }
+
+    std::cout << images.size() << " images, " << lines << " lines" << std::endl;
+    std::cout << "one by one : " << std::chrono::duration<double, std::milli>(mid - start).count() << " ms" << std::endl;
+    std::cout << "batched    : " << std::chrono::duration<double, std::milli>(end - mid).count() << " ms" << std::endl;
+    std::cout << mismatches << " mismatches" << std::endl;
+
+    auto recognized = [](const std::vector<std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>>& results) {
+        size_t count = 0;
+        for (const auto& result : results) {
+            for (const auto& textline : result.second) {
+                if (!textline.text.empty()) count++;
+            }
+        }
+        return count;
+    };
+    size_t full_lines = recognized(batched);
+
+    // the batch is one request, cancelled midway it keeps what is done so far
+    double batched_ms = std::chrono::duration<double, std::milli>(end - mid).count();
+    LiteOCR::RequestOption cancelled;
+    std::thread canceller([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(batched_ms / 4) + 1));
+        cancelled.cancel.cancel();
+    });
+    LiteOCR::RequestStatus cancel_status;
+    auto partial = engine.recognizeBatch(mats, cancelled, &cancel_status);
+    canceller.join();
+    size_t partial_lines = recognized(partial);
+    std::cout << "cancelled  : " << partial_lines << " of " << full_lines << " lines, status " << (int)cancel_status << std::endl;
+    bool cancel_ok = cancel_status == LiteOCR::RequestStatus::Cancelled && partial.size() == images.size()
+        && partial_lines < full_lines;
+
+    // an unknown language fails the whole batch without any work
+    LiteOCR::RequestOption unknown;
+    unknown.language = "unregistered";
+    LiteOCR::RequestStatus unknown_status;
+    auto failed = engine.recognizeBatch(mats, unknown, &unknown_status);
+    bool unknown_ok = unknown_status == LiteOCR::RequestStatus::Failed && failed.size() == images.size() && recognized(failed) == 0;
+    std::cout << "unknown language status " << (int)unknown_status << std::endl;
+
+    // sharing recognition batches with other images must not change any line
+    return mismatches == 0 && cancel_ok && unknown_ok ? 0 : 1;
+}
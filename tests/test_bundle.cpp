@@ -0,0 +1,102 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+// text of every recognized line, one per row
+static std::string text_of(const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+    std::string text;
+    for (const auto& textline : result.second) {
+        text += textline.text + "\n";
+    }
+    return text;
+}
+
+int main() {
+    const char* inputfile = "table.jpg";
+    const char* bundlePath = "./models/test_bundle.locr";
+
+    std::ifstream ifs(inputfile, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+    std::vector<unsigned char> imgData((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    int size = static_cast<int>(imgData.size());
+
+    LiteOCR::BundleFiles files;
+    files.detParam = "./models/PP-OCRv5_mobile_det.param";
+    files.detBin = "./models/PP-OCRv5_mobile_det.bin";
+    files.recParam = "./models/PP-OCRv5_mobile_rec.param";
+    files.recBin = "./models/PP-OCRv5_mobile_rec.bin";
+    files.vocab = "./models/PP-OCRv5_vocab.txt";
+    files.oriParam = "./models/PP-LCNet_x0_25_textline_ori.param";
+    files.oriBin = "./models/PP-LCNet_x0_25_textline_ori.bin";
+    files.tableCnnParam = "./models/PP-StructrureV2_SLANet_plus_cnn.param";
+    files.tableCnnBin = "./models/PP-StructrureV2_SLANet_plus_cnn.bin";
+    files.tableHeadParam = "./models/PP-StructrureV2_SLANet_plus_slahead.param";
+    files.tableHeadBin = "./models/PP-StructrureV2_SLANet_plus_slahead.bin";
+    files.tableVocab = "./models/table_structure_dict_ch.txt";
+    if (!LiteOCR::packBundle(files, bundlePath)) {
+        std::cerr << "Failed to pack bundle" << std::endl;
+        return -1;
+    }
+
+    auto ms_since = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    LiteOCR::LiteOCREngine files_engine;
+    LiteOCR::LiteOCRTableEngine files_table;
+    bool ok = files_engine.loadModel(files.detParam, files.detBin, files.recParam, files.recBin, files.vocab, files.oriParam, files.oriBin)
+           && files_table.loadModel(files.tableCnnParam, files.tableCnnBin, files.tableHeadParam, files.tableHeadBin, files.tableVocab);
+    double files_ms = ms_since(start);
+
+    start = std::chrono::steady_clock::now();
+    LiteOCR::LiteOCREngine bundle_engine;
+    LiteOCR::LiteOCRTableEngine bundle_table;
+    ok = ok && bundle_engine.loadBundle(bundlePath) && bundle_table.loadBundle(bundlePath);
+    double bundle_ms = ms_since(start);
+    if (!ok) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    std::cout << "separate files : " << files_ms << " ms" << std::endl;
+    std::cout << "bundle         : " << bundle_ms << " ms" << std::endl;
+
+    int failed = 0;
+    auto files_result = files_engine.recognize(imgData.data(), size);
+    auto bundle_result = bundle_engine.recognize(imgData.data(), size);
+    bool same_text = text_of(files_result) == text_of(bundle_result)
+                  && files_result.second.size() == bundle_result.second.size();
+    for (size_t i = 0; same_text && i < files_result.second.size(); i++) {
+        same_text = files_result.second[i].text == bundle_result.second[i].text;
+    }
+    std::cout << "same text " << same_text << std::endl;
+    if (!same_text) failed++;
+
+    auto files_html = files_table.recognize(imgData.data(), size, files_result).first;
+    auto bundle_html = bundle_table.recognize(imgData.data(), size, bundle_result).first;
+    std::cout << "same table " << (files_html == bundle_html) << std::endl;
+    if (files_html != bundle_html) failed++;
+
+    // an OCR only bundle has nothing for the table engine
+    LiteOCR::BundleFiles ocr_files = files;
+    ocr_files.tableCnnParam = ocr_files.tableCnnBin = ocr_files.tableHeadParam = ocr_files.tableHeadBin = ocr_files.tableVocab = nullptr;
+    // a new file, rewriting the bundle in use would pull the pages from under the loaded engines
+    const char* ocrBundlePath = "./models/test_bundle_ocr.locr";
+    LiteOCR::LiteOCRTableEngine no_table;
+    if (!LiteOCR::packBundle(ocr_files, ocrBundlePath) || no_table.loadBundle(ocrBundlePath)) failed++;
+
+    // not a bundle at all
+    LiteOCR::LiteOCREngine not_bundle;
+    if (not_bundle.loadBundle(files.vocab)) failed++;
+
+    std::remove(bundlePath);
+    std::remove(ocrBundlePath);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <thread>
+#include <vector>
+int main() {
+    const char* inputfile = "test2.png";
+
+    LiteOCR::LiteOCREngine engine;
+    bool ok = engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt"
+    );
+    if (!ok) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+
+    auto ifs = std::ifstream(inputfile, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+    std::vector<unsigned char> imgData((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    int size = static_cast<int>(imgData.size());
+
+    auto timed = [&](const LiteOCR::RequestOption& req, LiteOCR::RequestStatus& status, size_t& recognized) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = engine.recognize(imgData.data(), size, req, &status);
+        recognized = 0;
+        for (const auto& textline : result.second) {
+            if (!textline.text.empty()) recognized++;
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    LiteOCR::RequestStatus full_status, budget_status, cancel_status;
+    size_t full_lines, budget_lines, cancel_lines;
+    double full_ms = timed(LiteOCR::RequestOption(), full_status, full_lines);
+
+    LiteOCR::RequestOption budget;
+    budget.timeBudgetMs = std::max(1, static_cast<int>(full_ms / 3));
+    double budget_ms = timed(budget, budget_status, budget_lines);
+
+    // cancel from another thread while the request runs
+    LiteOCR::RequestOption cancelled;
+    std::thread canceller([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(full_ms / 4) + 1));
+        cancelled.cancel.cancel();
+    });
+    double cancel_ms = timed(cancelled, cancel_status, cancel_lines);
+    canceller.join();
+
+    std::cout << "full      : " << full_ms << " ms, " << full_lines << " lines, status " << (int)full_status << std::endl;
+    std::cout << "budget    : " << budget_ms << " ms, " << budget_lines << " lines, status " << (int)budget_status << std::endl;
+    std::cout << "cancelled : " << cancel_ms << " ms, " << cancel_lines << " lines, status " << (int)cancel_status << std::endl;
+
+    bool pass = full_status == LiteOCR::RequestStatus::Ok
+        && budget_status == LiteOCR::RequestStatus::TimedOut && budget_lines <= full_lines
+        && cancel_status == LiteOCR::RequestStatus::Cancelled && cancel_lines <= full_lines;
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,76 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <thread>
+int main() {
+    const char* inputfile = "test2.png";
+    const int numCallers = 4;
+
+    LiteOCR::InferOption opt;
+    opt.numThreads = 1;
+
+    LiteOCR::LiteOCREngine engine;
+    bool ok = engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        "./models/PP-LCNet_x0_25_textline_ori.param",
+        "./models/PP-LCNet_x0_25_textline_ori.bin",
+        opt
+    );
+    if (!ok) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+
+    std::vector<unsigned char> imgData;
+    auto ifs = std::ifstream(inputfile, std::ios::binary);
+    if (!ifs.is_open()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+
+    ifs.seekg(0, std::ios::end);
+    size_t fileSize = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+    imgData.resize(fileSize);
+    ifs.read(reinterpret_cast<char*>(imgData.data()), fileSize);
+    ifs.close();
+
+    auto expected = engine.recognize(imgData.data(), imgData.size());
+
+    // every caller shares the one engine, results must match the single threaded run
+    std::vector<int> mismatches(numCallers, 0);
+    std::vector<std::thread> callers;
+    for (int t = 0; t < numCallers; t++) {
+        callers.emplace_back([&, t]() {
+            for (int round = 0; round < 5; round++) {
+                auto result = engine.recognize(imgData.data(), imgData.size());
+                if (result.second.size() != expected.second.size()) {
+                    mismatches[t]++;
+                    continue;
+                }
+                for (size_t i = 0; i < result.second.size(); i++) {
+                    if (result.second[i].text != expected.second[i].text) {
+                        mismatches[t]++;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& caller : callers) {
+        caller.join();
+    }
+
+    int total = 0;
+    for (int t = 0; t < numCallers; t++) {
+        std::cout << "Caller " << t << ": " << mismatches[t] << " mismatches" << std::endl;
+        total += mismatches[t];
+    }
+    std::cout << "Detected " << expected.first.size() << " text boxes, " << numCallers << " callers" << std::endl;
+
+    return total == 0 ? 0 : 1;
+}
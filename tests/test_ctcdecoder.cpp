@@ -0,0 +1,99 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <opencv2/core.hpp>
+
+#include "BaseInfer.h"
+#include <vector>
+using namespace std;
+using namespace LiteOCR;
+
+// previous decoder, bounds-checked scalar argmax
+static std::vector<std::tuple<int, float, int>> reference_decode(const cv::Mat& probs, int blank_index = 0)
+{
+    std::vector<std::tuple<int, float, int>> result;
+    int prev_index = -1;
+    for (int i = 0; i < probs.rows; i++) {
+        float max_value = -1e10;
+        int max_index = -1;
+        for (int j = 0; j < probs.cols; j++) {
+            float value = probs.at<float>(i, j);
+            if (value > max_value) {
+                max_value = value;
+                max_index = j;
+            }
+        }
+        if (max_index != blank_index && max_index != prev_index) {
+            result.push_back(std::make_tuple(max_index, max_value, i));
+        }
+        prev_index = max_index;
+    }
+    return result;
+}
+
+// softmax-like rows, a peak per time step with runs of repeats and blanks, like a real line
+static cv::Mat synthetic_probs(int steps, int classes, unsigned seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(0.f, 1e-4f);
+    std::uniform_int_distribution<int> token(1, classes - 1);
+    std::uniform_int_distribution<int> run(1, 3);
+
+    cv::Mat probs(steps, classes, CV_32FC1);
+    int current = 0, left = 0;
+    for (int i = 0; i < steps; i++) {
+        if (left == 0) {
+            current = (i % 2) ? 0 : token(rng);
+            left = run(rng);
+        }
+        left--;
+        float* row = probs.ptr<float>(i);
+        for (int j = 0; j < classes; j++) {
+            row[j] = noise(rng);
+        }
+        row[current] = 0.5f + noise(rng) * 1000.f;
+        // equal values must resolve to the first index
+        if (i % 7 == 0 && current + 1 < classes) {
+            row[current + 1] = row[current];
+        }
+    }
+    return probs;
+}
+
+template <typename Fn>
+static double bench_ms(int loops, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; i++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / loops;
+}
+
+int main() {
+    cout << "LiteOCR CTC Decoder Benchmark" << std::endl;
+
+    // PP-OCRv5 dictionary size, one long line
+    const int classes = 18385;
+    const int steps = 160;
+    const int loops = 50;
+
+    bool same = true;
+    std::vector<std::tuple<int, float, int>> ref, fast;
+    for (unsigned seed = 0; seed < 4; seed++) {
+        cv::Mat probs = synthetic_probs(steps, classes - seed, seed);
+        same = same && reference_decode(probs) == CTCDecoder::decode(probs);
+    }
+
+    cv::Mat probs = synthetic_probs(steps, classes, 42);
+    double ref_ms = bench_ms(loops, [&]() { ref = reference_decode(probs); });
+    double fast_ms = bench_ms(loops, [&]() { fast = CTCDecoder::decode(probs); });
+
+    cout << "matrix     : " << probs.rows << "x" << probs.cols << endl;
+    cout << "reference  : " << ref_ms << " ms, " << ref.size() << " tokens" << endl;
+    cout << "vectorized : " << fast_ms << " ms, " << fast.size() << " tokens, x" << ref_ms / fast_ms << endl;
+    cout << "results " << (same && ref == fast ? "match" : "differ") << endl;
+
+    return same && ref == fast ? 0 : 1;
+}
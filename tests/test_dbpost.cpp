@@ -0,0 +1,174 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+
+#include "BaseInfer.h"
+#include "ThreadPool.h"
+#include <opencv2/imgproc.hpp>
+#include <vector>
+using namespace std;
+using namespace LiteOCR;
+
+// reference post-processing, one mask allocation per contour
+static float contour_score(const cv::Mat& binary, const std::vector<cv::Point>& contour)
+{
+    cv::Rect rect = cv::boundingRect(contour);
+    if (rect.x < 0)
+        rect.x = 0;
+    if (rect.y < 0)
+        rect.y = 0;
+    if (rect.x + rect.width > binary.cols)
+        rect.width = binary.cols - rect.x;
+    if (rect.y + rect.height > binary.rows)
+        rect.height = binary.rows - rect.y;
+
+    cv::Mat binROI = binary(rect);
+
+    cv::Mat mask = cv::Mat::zeros(rect.height, rect.width, CV_8U);
+    std::vector<cv::Point> roiContour;
+    for (size_t i = 0; i < contour.size(); i++)
+    {
+        cv::Point pt = cv::Point(contour[i].x - rect.x, contour[i].y - rect.y);
+        roiContour.push_back(pt);
+    }
+
+    std::vector<std::vector<cv::Point> > roiContours = {roiContour};
+    cv::fillPoly(mask, roiContours, cv::Scalar(1.0f));
+
+    float score = cv::mean(binROI, mask).val[0];
+    return score;
+}
+
+static std::vector<TextBox> reference_process(const cv::Mat& pred, const DBPostProcess& post)
+{
+    cv::Mat binary;
+    cv::threshold(pred, binary, post.threshold, 1, cv::THRESH_BINARY);
+    binary.convertTo(binary, CV_8U, 255);
+
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(binary, contours, cv::RETR_LIST, cv::CHAIN_APPROX_SIMPLE);
+
+    contours.resize(std::min(contours.size(), (size_t)post.max_candidates));
+
+    std::vector<TextBox> textBoxes;
+    for (const auto& contour : contours) {
+        if (contour.size() < 4) continue;
+
+        float score = contour_score(pred, contour);
+        if (score < post.box_threshold) continue;
+
+        cv::RotatedRect box = cv::minAreaRect(contour);
+        bool vertical = DBPostProcess::normalizeBox(box);
+
+        box.size.height += box.size.width * (post.unclip_ratio - 1);
+        box.size.width *= post.unclip_ratio;
+
+        textBoxes.push_back(DBPostProcess::toTextBox(box, vertical, score));
+    }
+    return textBoxes;
+}
+
+static float rotated_iou(const TextBox& a, const TextBox& b)
+{
+    cv::RotatedRect ra(cv::Point2f(a.box.center.x, a.box.center.y), cv::Size2f(a.box.size.width, a.box.size.height), a.box.angle);
+    cv::RotatedRect rb(cv::Point2f(b.box.center.x, b.box.center.y), cv::Size2f(b.box.size.width, b.box.size.height), b.box.angle);
+    std::vector<cv::Point2f> region;
+    if (cv::rotatedRectangleIntersection(ra, rb, region) == cv::INTERSECT_NONE || region.size() < 3) {
+        return 0.f;
+    }
+    std::vector<cv::Point2f> hull;
+    cv::convexHull(region, hull);
+    float inter = static_cast<float>(cv::contourArea(hull));
+    return inter / (ra.size.area() + rb.size.area() - inter);
+}
+
+template <typename Fn>
+static double bench_ms(int loops, Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loops; i++) {
+        fn();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / loops;
+}
+
+int main() {
+    cout << "LiteOCR DB PostProcess Benchmark" << std::endl;
+
+    cv::Mat input = cv::imread("test.png", cv::IMREAD_COLOR);
+    if (input.empty()) {
+        cerr << "Failed to open test.png" << endl;
+        return -1;
+    }
+
+    PaddleDetector detector;
+    detector.loadModel("./models/PP-OCRv5_mobile_det.param", "./models/PP-OCRv5_mobile_det.bin", InferOption());
+    cv::Mat pred = detector.forward(input);
+    cout << "Probability map: " << pred.cols << "x" << pred.rows << endl;
+
+    DBPostProcess post;
+    ThreadPool pool(3);
+    const int loops = 20;
+
+    std::vector<TextBox> ref, fast, fast_mt;
+    double ref_ms = bench_ms(loops, [&]() { ref = reference_process(pred, post); });
+    double fast_ms = bench_ms(loops, [&]() { fast = post.process(pred); });
+    double fast_mt_ms = bench_ms(loops, [&]() { fast_mt = post.process(pred, 1.f, 1.f, 0.f, 0.f, nullptr, &pool); });
+
+    cout << "reference      : " << ref_ms << " ms, " << ref.size() << " boxes" << endl;
+    cout << "reused mask    : " << fast_ms << " ms, " << fast.size() << " boxes, x" << ref_ms / fast_ms << endl;
+    cout << "reused 4 thr   : " << fast_mt_ms << " ms, " << fast_mt.size() << " boxes, x" << ref_ms / fast_mt_ms << endl;
+
+    // same boxes in the same order, scores up to float rounding
+    auto same = [](const std::vector<TextBox>& a, const std::vector<TextBox>& b, float& max_score_diff) {
+        max_score_diff = 0.f;
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); i++) {
+            const auto& x = a[i].box;
+            const auto& y = b[i].box;
+            if (x.center.x != y.center.x || x.center.y != y.center.y || x.size.width != y.size.width
+                || x.size.height != y.size.height || x.angle != y.angle || a[i].isVertical != b[i].isVertical) {
+                return false;
+            }
+            max_score_diff = std::max(max_score_diff, std::abs(a[i].score - b[i].score));
+        }
+        return max_score_diff <= 1e-5f;
+    };
+    float score_diff = 0.f, score_diff_mt = 0.f;
+    bool same_st = same(ref, fast, score_diff);
+    bool same_mt = same(ref, fast_mt, score_diff_mt);
+    cout << "same boxes " << same_st << " / " << same_mt << " (4 thr), max score diff "
+         << std::max(score_diff, score_diff_mt) << endl;
+
+    // accuracy / speed of post-processing on a downsampled map, against the full resolution boxes
+    for (int downscale : {2, 4}) {
+        DBPostProcess small_post;
+        small_post.downscale = downscale;
+        std::vector<TextBox> small;
+        double small_ms = bench_ms(loops, [&]() { small = small_post.process(pred); });
+
+        int found = 0;
+        double iou_sum = 0;
+        for (const auto& f : fast) {
+            float best = 0.f;
+            for (const auto& b : small) {
+                best = std::max(best, rotated_iou(f, b));
+            }
+            if (best >= 0.5f) {
+                found++;
+                iou_sum += best;
+            }
+        }
+        cout << "1/" << downscale << " map      : " << small_ms << " ms, x" << fast_ms / small_ms << " vs full map, "
+             << small.size() << " boxes, recall " << (fast.empty() ? 1.0 : (double)found / fast.size())
+             << ", mean IoU " << (found ? iou_sum / found : 0.0) << endl;
+    }
+
+    // the point of the rewrite: no slower single threaded, faster with the pool
+    bool faster = fast_ms <= ref_ms && fast_mt_ms < ref_ms;
+    cout << "faster than reference " << faster << endl;
+    return same_st && same_mt && faster ? 0 : 1;
+}
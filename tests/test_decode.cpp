@@ -0,0 +1,79 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "BaseInfer.h"
+#include "LiteOCREngine.h"
+using namespace std;
+using namespace LiteOCR;
+
+int main() {
+    cv::Mat page = cv::imread("test.png", cv::IMREAD_COLOR);
+    if (page.empty()) {
+        cerr << "Failed to open test.png" << endl;
+        return -1;
+    }
+    // a large scan, the case reduced decoding is for
+    cv::Mat scan;
+    cv::resize(page, scan, cv::Size(page.cols * 2, page.rows * 2), 0, 0, cv::INTER_CUBIC);
+    std::vector<unsigned char> jpeg;
+    cv::imencode(".jpg", scan, jpeg, {cv::IMWRITE_JPEG_QUALITY, 95});
+
+    int failed = 0;
+    int width = 0, height = 0;
+    bool found = jpeg_size(jpeg.data(), static_cast<int>(jpeg.size()), width, height);
+    cout << "jpeg header : " << width << "x" << height << ", image " << scan.cols << "x" << scan.rows << endl;
+    if (!found || width != scan.cols || height != scan.rows) failed++;
+
+    std::vector<unsigned char> png;
+    cv::imencode(".png", page, png);
+    if (jpeg_size(png.data(), static_cast<int>(png.size()), width, height)) failed++;
+
+    for (int reduction : {1, 2, 4, 8}) {
+        auto start = std::chrono::steady_clock::now();
+        cv::Mat img = decode_image(jpeg.data(), static_cast<int>(jpeg.size()), reduction);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        cout << "decode 1/" << reduction << "  : " << ms << " ms, " << img.cols << "x" << img.rows << endl;
+        if (img.cols != (scan.cols + reduction - 1) / reduction) failed++;
+    }
+
+    // with a detection size limit the detector only sees a reduced decode, text should not change
+    InferOption opt;
+    opt.detLimitSideLen = std::max(page.cols, page.rows);
+    LiteOCREngine engine;
+    bool ok = engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        nullptr, nullptr, opt
+    );
+    if (!ok) {
+        cerr << "Failed to load models" << endl;
+        return -1;
+    }
+
+    cv::Mat decoded = cv::imdecode(jpeg, cv::IMREAD_COLOR);
+    auto start = std::chrono::steady_clock::now();
+    auto full = engine.recognize(&decoded);
+    auto mid = std::chrono::steady_clock::now();
+    auto reduced = engine.recognize(jpeg.data(), static_cast<int>(jpeg.size()));
+    auto end = std::chrono::steady_clock::now();
+
+    size_t same = 0;
+    for (size_t i = 0; i < std::min(full.second.size(), reduced.second.size()); i++) {
+        if (full.second[i].text == reduced.second[i].text) same++;
+    }
+    cout << "decoded mat : " << std::chrono::duration<double, std::milli>(mid - start).count() << " ms (decode not counted), "
+         << full.second.size() << " lines" << endl;
+    cout << "jpeg bytes  : " << std::chrono::duration<double, std::milli>(end - mid).count() << " ms, "
+         << reduced.second.size() << " lines, " << same << " with the same text" << endl;
+    if (reduced.second.empty() || same * 10 < full.second.size() * 9) failed++;
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,110 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+// text of every recognized line, one per row
+static std::string text_of(const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+    std::string text;
+    for (const auto& textline : result.second) {
+        text += textline.text + "\n";
+    }
+    return text;
+}
+
+int main() {
+    const char* inputfile = "test2.png";
+    const char* bundlePath = "./models/test_language.locr";
+    cv::Mat image = cv::imread(inputfile, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+
+    LiteOCR::BundleFiles files;
+    files.recParam = "./models/PP-OCRv5_mobile_rec.param";
+    files.recBin = "./models/PP-OCRv5_mobile_rec.bin";
+    files.vocab = "./models/PP-OCRv5_vocab.txt";
+    if (!LiteOCR::packBundle(files, bundlePath)) {
+        std::cerr << "Failed to pack bundle" << std::endl;
+        return -1;
+    }
+
+    // a budget below two recognizers, every language switch unloads the other one
+    LiteOCR::InferOption opt;
+    opt.recognizerBudgetMB = 1;
+    opt.numWorkers = 2;
+    LiteOCR::LiteOCREngine engine;
+    if (!engine.loadModel(
+            "./models/PP-OCRv5_mobile_det.param",
+            "./models/PP-OCRv5_mobile_det.bin",
+            files.recParam, files.recBin, files.vocab,
+            nullptr, nullptr, opt)) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    engine.registerRecognizer("files", files.recParam, files.recBin, files.vocab);
+    engine.registerRecognizerBundle("bundle", bundlePath);
+
+    auto text = [&](const std::string& language, LiteOCR::RequestStatus& status, double& ms) {
+        LiteOCR::RequestOption req;
+        req.language = language;
+        auto start = std::chrono::steady_clock::now();
+        auto result = engine.recognize(&image, req, &status);
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return text_of(result) + "\n" + std::to_string(result.second.size());
+    };
+
+    int failed = 0;
+    LiteOCR::RequestStatus status;
+    double ms;
+    std::string reference = text("", status, ms);
+    std::cout << "default        : " << ms << " ms" << std::endl;
+    if (engine.recognizerStats().loads != 0) failed++;
+
+    for (const char* language : {"files", "files", "bundle", "files"}) {
+        bool same = text(language, status, ms) == reference;
+        std::cout << language << " : " << ms << " ms, same text " << same << std::endl;
+        if (!same || status != LiteOCR::RequestStatus::Ok) failed++;
+    }
+    LiteOCR::RecognizerStats stats = engine.recognizerStats();
+    std::cout << "loads " << stats.loads << ", evictions " << stats.evictions << ", "
+              << stats.loaded.size() << " loaded, " << stats.loadedBytes / 1024 << " KB" << std::endl;
+    // files, bundle, files again, each one replacing the last
+    if (stats.loads != 3 || stats.evictions != 2 || stats.loaded.size() != 1 || stats.loaded[0] != "files") failed++;
+
+    std::string unknown = text("klingon", status, ms);
+    std::cout << "unknown        : failed " << (status == LiteOCR::RequestStatus::Failed) << std::endl;
+    if (status != LiteOCR::RequestStatus::Failed || unknown != "\n0") failed++;
+
+    // languages switching under concurrent requests, an evicted model stays alive for the
+    // requests still reading with it
+    std::vector<std::thread> threads;
+    std::vector<int> mismatches(4, 0);
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < 4; i++) {
+                LiteOCR::RequestStatus thread_status;
+                double thread_ms;
+                if (text((t + i) % 2 ? "files" : "bundle", thread_status, thread_ms) != reference) {
+                    mismatches[t]++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < 4; t++) {
+        failed += mismatches[t];
+    }
+    std::cout << "concurrent     : " << engine.recognizerStats().evictions << " evictions so far" << std::endl;
+
+    std::remove(bundlePath);
+    return failed == 0 ? 0 : 1;
+}
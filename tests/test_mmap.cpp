@@ -0,0 +1,102 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+// text of every recognized line, one per row
+static std::string text_of(const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+    std::string text;
+    for (const auto& textline : result.second) {
+        text += textline.text + "\n";
+    }
+    return text;
+}
+
+static std::vector<unsigned char> read_file(const char* path, bool text = false) {
+    std::ifstream ifs(path, std::ios::binary);
+    std::vector<unsigned char> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    if (text) {
+        data.push_back(0);
+    }
+    return data;
+}
+
+int main() {
+    const char* inputfile = "test2.png";
+    cv::Mat image = cv::imread(inputfile, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+
+    auto load = [](LiteOCR::LiteOCREngine& engine, const LiteOCR::InferOption& opt, double& ms) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = engine.loadModel(
+            "./models/PP-OCRv5_mobile_det.param",
+            "./models/PP-OCRv5_mobile_det.bin",
+            "./models/PP-OCRv5_mobile_rec.param",
+            "./models/PP-OCRv5_mobile_rec.bin",
+            "./models/PP-OCRv5_vocab.txt",
+            nullptr, nullptr, opt
+        );
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return ok;
+    };
+
+    LiteOCR::InferOption read_opt;
+    LiteOCR::InferOption mmap_opt;
+    mmap_opt.useMmap = true;
+
+    double read_ms, mmap_ms, mmap_again_ms;
+    LiteOCR::LiteOCREngine read_engine, mmap_engine, mmap_again;
+    if (!load(read_engine, read_opt, read_ms) || !load(mmap_engine, mmap_opt, mmap_ms) || !load(mmap_again, mmap_opt, mmap_again_ms)) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    std::cout << "read load   : " << read_ms << " ms" << std::endl;
+    std::cout << "mmap load   : " << mmap_ms << " ms, second engine " << mmap_again_ms << " ms" << std::endl;
+
+    // buffers have to outlive the engine, the weights are not copied out of them
+    auto det_param = read_file("./models/PP-OCRv5_mobile_det.param", true);
+    auto det_bin = read_file("./models/PP-OCRv5_mobile_det.bin");
+    auto rec_param = read_file("./models/PP-OCRv5_mobile_rec.param", true);
+    auto rec_bin = read_file("./models/PP-OCRv5_mobile_rec.bin");
+    auto vocab = read_file("./models/PP-OCRv5_vocab.txt", true);
+    LiteOCR::LiteOCREngine buffer_engine;
+    if (!buffer_engine.loadModelFromBuffer(
+            reinterpret_cast<const char*>(det_param.data()), det_bin.data(),
+            reinterpret_cast<const char*>(rec_param.data()), rec_bin.data(),
+            reinterpret_cast<const char*>(vocab.data()))) {
+        std::cerr << "Failed to load models from buffer" << std::endl;
+        return -1;
+    }
+
+    std::string reference = text_of(read_engine.recognize(&image));
+    int failed = 0;
+    auto check = [&](const char* name, LiteOCR::LiteOCREngine& engine) {
+        bool same = text_of(engine.recognize(&image)) == reference;
+        std::cout << name << "same text " << same << std::endl;
+        if (!same) failed++;
+    };
+    check("mmap        : ", mmap_engine);
+    check("mmap again  : ", mmap_again);
+    check("buffer      : ", buffer_engine);
+
+    // a missing file fails the load instead of mapping nothing
+    LiteOCR::LiteOCREngine missing;
+    bool missing_ok = missing.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/missing.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        nullptr, nullptr, mmap_opt
+    );
+    if (missing_ok) failed++;
+
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/highgui.hpp>
+#include <opencv2/imgproc.hpp>
+// text of every recognized line, one per row
+static std::string text_of(const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+    std::string text;
+    for (const auto& textline : result.second) {
+        text += textline.text + "\n";
+    }
+    return text;
+}
+
+int main() {
+    const char* inputfile = "test2.png";
+
+    LiteOCR::LiteOCREngine engine;
+    bool ok = engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt"
+    );
+    if (!ok) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+
+    cv::Mat bgr = cv::imread(inputfile, cv::IMREAD_COLOR);
+    if (bgr.empty()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+    cv::Mat rgb, bgra, rgba, gray, gray_bgr;
+    cv::cvtColor(bgr, rgb, cv::COLOR_BGR2RGB);
+    cv::cvtColor(bgr, bgra, cv::COLOR_BGR2BGRA);
+    cv::cvtColor(bgr, rgba, cv::COLOR_BGR2RGBA);
+    cv::cvtColor(bgr, gray, cv::COLOR_BGR2GRAY);
+    cv::cvtColor(gray, gray_bgr, cv::COLOR_GRAY2BGR);
+
+    // rows padded to a larger stride, like a camera frame buffer
+    int stride = (bgr.cols * 3 + 63) / 64 * 64 + 64;
+    std::vector<unsigned char> strided(static_cast<size_t>(stride) * bgr.rows);
+    for (int y = 0; y < bgr.rows; y++) {
+        memcpy(&strided[static_cast<size_t>(y) * stride], bgr.ptr(y), bgr.cols * 3);
+    }
+
+    auto text = [&](const unsigned char* data, LiteOCR::PixelFormat format, int step, double& ms) {
+        auto start = std::chrono::steady_clock::now();
+        auto result = engine.recognize(data, bgr.cols, bgr.rows, format, step);
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return text_of(result) + "\n" + std::to_string(result.second.size());
+    };
+
+    double ms;
+    std::string reference = text(bgr.data, LiteOCR::PixelFormat::BGR, static_cast<int>(bgr.step[0]), ms);
+    std::cout << "bgr     : " << ms << " ms" << std::endl;
+
+    int failed = 0;
+    auto check = [&](const char* name, const cv::Mat& image, LiteOCR::PixelFormat format, const std::string& expected) {
+        std::string result = text(image.data, format, static_cast<int>(image.step[0]), ms);
+        bool same = result == expected;
+        std::cout << name << ms << " ms, same as converted input " << same << std::endl;
+        if (!same) failed++;
+    };
+    check("rgb     : ", rgb, LiteOCR::PixelFormat::RGB, reference);
+    check("bgra    : ", bgra, LiteOCR::PixelFormat::BGRA, reference);
+    check("rgba    : ", rgba, LiteOCR::PixelFormat::RGBA, reference);
+
+    std::string strided_result = text(strided.data(), LiteOCR::PixelFormat::BGR, stride, ms);
+    std::cout << "strided : " << ms << " ms, same as converted input " << (strided_result == reference) << std::endl;
+    if (strided_result != reference) failed++;
+
+    // gray read in place against the old full conversion to BGR
+    std::string gray_reference = text(gray_bgr.data, LiteOCR::PixelFormat::BGR, static_cast<int>(gray_bgr.step[0]), ms);
+    check("gray    : ", gray, LiteOCR::PixelFormat::Gray, gray_reference);
+
+    return failed == 0 ? 0 : 1;
+}
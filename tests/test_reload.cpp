@@ -0,0 +1,92 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+// text of every recognized line, one per row
+static std::string text_of(const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+    std::string text;
+    for (const auto& textline : result.second) {
+        text += textline.text + "\n";
+    }
+    return text;
+}
+
+static bool reload(LiteOCR::LiteOCREngine& engine) {
+    return engine.reloadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt"
+    );
+}
+
+int main() {
+    const char* inputfile = "test2.png";
+    const char* bundlefile = "test_reload.locr";
+    const int threads = 4;
+    const int reloads = 6;
+
+    cv::Mat image = cv::imread(inputfile, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+
+    LiteOCR::BundleFiles files;
+    files.detParam = "./models/PP-OCRv5_mobile_det.param";
+    files.detBin = "./models/PP-OCRv5_mobile_det.bin";
+    files.recParam = "./models/PP-OCRv5_mobile_rec.param";
+    files.recBin = "./models/PP-OCRv5_mobile_rec.bin";
+    files.vocab = "./models/PP-OCRv5_vocab.txt";
+    LiteOCR::LiteOCREngine engine;
+    if (!LiteOCR::packBundle(files, bundlefile) || !engine.loadBundle(bundlefile)) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    engine.warmup();
+    std::string reference = text_of(engine.recognize(&image));
+
+    // requests keep running on every thread while the models are swapped under them
+    std::atomic<bool> done{false};
+    std::atomic<int> requests{0}, mismatches{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&]() {
+            while (!done.load()) {
+                auto text = text_of(engine.recognize(&image));
+                if (text != reference) mismatches++;
+                requests++;
+            }
+        });
+    }
+
+    int failed = 0;
+    double reload_ms = 0;
+    for (int i = 0; i < reloads; i++) {
+        auto start = std::chrono::steady_clock::now();
+        bool ok = i % 2 == 0 ? reload(engine) : engine.reloadBundle(bundlefile);
+        reload_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (!ok) failed++;
+    }
+
+    // a failed reload keeps the current models serving
+    bool kept = !engine.reloadBundle("./models/missing.locr");
+    done = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    kept = kept && text_of(engine.recognize(&image)) == reference;
+    bool warm = engine.startupStats().warm;
+
+    std::cout << "reloads  : " << reloads << ", " << reload_ms / reloads << " ms each, " << failed << " failed" << std::endl;
+    std::cout << "requests : " << requests.load() << " during reloads, " << mismatches.load() << " with other text" << std::endl;
+    std::cout << "failed reload keeps serving " << kept << ", reloaded set warm " << warm << std::endl;
+    return failed == 0 && mismatches == 0 && kept && warm ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+#include <iostream>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Scheduler.h"
+using namespace std;
+using namespace LiteOCR;
+
+int main() {
+    cout << "LiteOCR Scheduler Test" << std::endl;
+
+    Scheduler scheduler;
+    scheduler.setSlots(1);
+
+    // keep the only slot busy while the others queue up
+    RequestState holder;
+    scheduler.acquire(Scheduler::Recognize, holder);
+
+    std::mutex mutex;
+    std::vector<int> order;
+    std::vector<std::thread> requests;
+    for (int priority : {0, 0, 5, 1}) {
+        requests.emplace_back([&, priority]() {
+            RequestOption opt;
+            opt.priority = priority;
+            RequestState req(opt);
+            if (scheduler.acquire(Scheduler::Recognize, req)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    order.push_back(priority);
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                scheduler.release(Scheduler::Recognize);
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    bool late_admitted = true;
+    requests.emplace_back([&]() {
+        RequestOption opt;
+        opt.priority = 10;
+        opt.deadlineMs = 20;
+        RequestState req(opt);
+        late_admitted = scheduler.acquire(Scheduler::Recognize, req);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    auto waiting = scheduler.stats(Scheduler::Recognize);
+    scheduler.release(Scheduler::Recognize);
+    for (auto& request : requests) {
+        request.join();
+    }
+    auto stats = scheduler.stats(Scheduler::Recognize);
+
+    cout << "admission order:";
+    for (int priority : order) {
+        cout << " " << priority;
+    }
+    cout << endl;
+    cout << "queue depth " << waiting.queueDepth << ", max " << stats.maxQueueDepth << ", admitted " << stats.admitted
+         << ", dropped " << stats.dropped << ", max wait " << stats.maxWaitMs << " ms" << endl;
+
+    bool ok = order == std::vector<int>{5, 1, 0, 0} && !late_admitted && stats.dropped == 1;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <thread>
+#include <vector>
+int main() {
+    const int numImages = 16;
+
+    LiteOCR::LiteOCREngine engine;
+    bool ok = engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        "./models/PP-LCNet_x0_25_textline_ori.param",
+        "./models/PP-LCNet_x0_25_textline_ori.bin"
+    );
+    if (!ok) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+
+    std::vector<std::vector<unsigned char>> files;
+    for (const char* inputfile : {"test.png", "test2.png"}) {
+        auto ifs = std::ifstream(inputfile, std::ios::binary);
+        if (!ifs.is_open()) {
+            std::cerr << "Failed to open image file: " << inputfile << std::endl;
+            return -1;
+        }
+        files.emplace_back(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>> expected;
+    for (int i = 0; i < numImages; i++) {
+        const auto& file = files[i % files.size()];
+        expected.push_back(engine.recognize(file.data(), static_cast<int>(file.size())));
+    }
+    auto mid = std::chrono::steady_clock::now();
+
+    LiteOCR::LiteOCRStream stream(engine);
+    std::thread producer([&]() {
+        for (int i = 0; i < numImages; i++) {
+            const auto& file = files[i % files.size()];
+            stream.push(i, file.data(), static_cast<int>(file.size()));
+        }
+        stream.close();
+    });
+
+    std::map<uint64_t, LiteOCR::StreamResult> results;
+    LiteOCR::StreamResult result;
+    while (stream.pop(result)) {
+        results[result.id] = std::move(result);
+    }
+    producer.join();
+    auto end = std::chrono::steady_clock::now();
+
+    int mismatches = 0;
+    for (int i = 0; i < numImages; i++) {
+        auto it = results.find(i);
+        if (it == results.end() || it->second.textlines.size() != expected[i].second.size()) {
+            mismatches++;
+            continue;
+        }
+        for (size_t j = 0; j < expected[i].second.size(); j++) {
+            if (it->second.textlines[j].text != expected[i].second[j].text) {
+                mismatches++;
+            }
+        }
+    }
+
+    std::cout << numImages << " images" << std::endl;
+    std::cout << "serial    : " << std::chrono::duration<double, std::milli>(mid - start).count() << " ms" << std::endl;
+    std::cout << "pipelined : " << std::chrono::duration<double, std::milli>(end - mid).count() << " ms" << std::endl;
+    std::cout << results.size() << " results, " << mismatches << " mismatches" << std::endl;
+
+    return results.size() == numImages && mismatches == 0 ? 0 : 1;
+}
@@ -2,11 +2,16 @@
 #include <opencv2/core.hpp>
 #include <opencv2/highgui.hpp>
 #include "BaseInfer.h"
+#include "LiteOCREngine.h"
 
 int main()
 {
     std::cout << "LiteOCR Textline Orientation Classifier Test" << std::endl;
     cv::Mat input = cv::imread("test_line.png", cv::IMREAD_COLOR);
+    if (input.empty()) {
+        std::cerr << "Failed to open test_line.png" << std::endl;
+        return -1;
+    }
 
     LiteOCR::PaddleTextlineORI classifier;
     classifier.loadModel("./models/PP-LCNet_x0_25_textline_ori.param", "./models/PP-LCNet_x0_25_textline_ori.bin", LiteOCR::InferOption());
@@ -14,8 +19,9 @@ int main()
     int orientation = classifier.forward(input);
     std::cout << "Predicted orientation: " << orientation << std::endl;
 
-    cv::rotate(input, input, cv::ROTATE_180);
-    int orientation2 = classifier.forward(input);
+    cv::Mat rotated;
+    cv::rotate(input, rotated, cv::ROTATE_180);
+    int orientation2 = classifier.forward(rotated);
     std::cout << "Predicted orientation after rotation: " << orientation2 << std::endl;
 
     if (orientation != orientation2) {
@@ -25,5 +31,59 @@ int main()
         return -1;
     }
 
+    // a short line, width twice the height: no aspect ratio tells its orientation, only the classifier
+    cv::Mat short_line = input(cv::Rect(0, 0, std::min(input.cols, input.rows * 2), input.rows)).clone();
+    cv::Mat short_rotated;
+    cv::rotate(short_line, short_rotated, cv::ROTATE_180);
+    auto whole = [](const cv::Mat& image) {
+        LiteOCR::TextlineCrop crop{image, {1.f, 0.f, 0.f, 0.f, 1.f, 0.f}, image.cols, image.rows};
+        return crop;
+    };
+    auto labels = classifier.forwardCrops({whole(short_line), whole(short_rotated)});
+    int short_upright = classifier.forward(short_line);
+    int short_flipped = classifier.forward(short_rotated);
+    std::cout << "Short line: forwardCrops " << labels[0] << " / " << labels[1]
+              << ", forward " << short_upright << " / " << short_flipped << std::endl;
+    if (labels[0] != 0 || labels[1] != 1 || labels[0] != short_upright || labels[1] != short_flipped) {
+        std::cout << "Short line orientation failed." << std::endl;
+        return -1;
+    }
+
+    // through the engine with the default oriMinAspect of 0, the upside-down short line is
+    // turned and reads the same as the upright one
+    LiteOCR::LiteOCREngine engine;
+    if (!engine.loadModel(
+            "./models/PP-OCRv5_mobile_det.param",
+            "./models/PP-OCRv5_mobile_det.bin",
+            "./models/PP-OCRv5_mobile_rec.param",
+            "./models/PP-OCRv5_mobile_rec.bin",
+            "./models/PP-OCRv5_vocab.txt",
+            "./models/PP-LCNet_x0_25_textline_ori.param",
+            "./models/PP-LCNet_x0_25_textline_ori.bin")) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    auto page = [&](const cv::Mat& line) {
+        cv::Mat padded;
+        cv::copyMakeBorder(line, padded, line.rows, line.rows, line.rows, line.rows, cv::BORDER_CONSTANT, cv::Scalar(255, 255, 255));
+        return padded;
+    };
+    auto text = [&](const cv::Mat& image) {
+        std::string joined;
+        for (const auto& line : engine.recognize(&image).second) {
+            joined += line.text;
+        }
+        return joined;
+    };
+    cv::Mat upright_page = page(short_line);
+    cv::Mat flipped_page = page(short_rotated);
+    std::string upright_text = text(upright_page);
+    std::string flipped_text = text(flipped_page);
+    std::cout << "Short line upright: \"" << upright_text << "\", upside down: \"" << flipped_text << "\"" << std::endl;
+    if (upright_text.empty() || upright_text != flipped_text) {
+        std::cout << "Short line was not corrected." << std::endl;
+        return -1;
+    }
+
     return 0;
-}
\ No newline at end of file
+}
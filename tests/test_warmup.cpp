@@ -0,0 +1,93 @@
+#include "LiteOCREngine.h"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+
+// text of every recognized line, one per row
+static std::string text_of(const std::pair<std::vector<LiteOCR::TextBox>, std::vector<LiteOCR::Textline>>& result) {
+    std::string text;
+    for (const auto& textline : result.second) {
+        text += textline.text + "\n";
+    }
+    return text;
+}
+
+static bool load(LiteOCR::LiteOCREngine& engine) {
+    return engine.loadModel(
+        "./models/PP-OCRv5_mobile_det.param",
+        "./models/PP-OCRv5_mobile_det.bin",
+        "./models/PP-OCRv5_mobile_rec.param",
+        "./models/PP-OCRv5_mobile_rec.bin",
+        "./models/PP-OCRv5_vocab.txt",
+        "./models/PP-LCNet_x0_25_textline_ori.param",
+        "./models/PP-LCNet_x0_25_textline_ori.bin"
+    );
+}
+
+static void print(const char* name, const LiteOCR::StartupStats& stats) {
+    std::cout << name << (stats.warm ? " (warm)" : " (cold)") << std::endl;
+    for (const auto& stage : stats.stages) {
+        std::cout << "  " << stage.name << " : load " << stage.loadMs << " ms, warm-up " << stage.warmupMs << " ms" << std::endl;
+    }
+}
+
+int main() {
+    const char* inputfile = "test2.png";
+    cv::Mat image = cv::imread(inputfile, cv::IMREAD_COLOR);
+    if (image.empty()) {
+        std::cerr << "Failed to open image file: " << inputfile << std::endl;
+        return -1;
+    }
+
+    LiteOCR::LiteOCREngine cold, warm;
+    if (!load(cold) || !load(warm)) {
+        std::cerr << "Failed to load models" << std::endl;
+        return -1;
+    }
+    LiteOCR::StartupStats stats = warm.warmup();
+    print("engine", stats);
+
+    auto first_call = [&](LiteOCR::LiteOCREngine& engine, std::string& text) {
+        auto start = std::chrono::steady_clock::now();
+        text = text_of(engine.recognize(&image));
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+    std::string cold_text, warm_text, steady_text;
+    double cold_ms = first_call(cold, cold_text);
+    double warm_ms = first_call(warm, warm_text);
+    double steady_ms = first_call(cold, steady_text);
+    std::cout << "first request, cold engine : " << cold_ms << " ms" << std::endl;
+    std::cout << "first request, warm engine : " << warm_ms << " ms" << std::endl;
+    std::cout << "second request             : " << steady_ms << " ms" << std::endl;
+
+    int failed = 0;
+    // warm-up leaves no trace in the results
+    if (warm_text != cold_text) failed++;
+    // every loaded stage reports a load time, and the models a warm-up time
+    const char* expected[] = {"detector", "recognizer", "orientation", "vocab"};
+    if (!stats.warm || stats.stages.size() != 4) failed++;
+    for (size_t i = 0; i < stats.stages.size() && i < 4; i++) {
+        const auto& stage = stats.stages[i];
+        if (stage.name != expected[i] || stage.loadMs <= 0) failed++;
+        if (stage.name != "vocab" && stage.warmupMs <= 0) failed++;
+    }
+    if (cold.startupStats().warm) failed++;
+
+    LiteOCR::LiteOCRTableEngine table;
+    if (!table.loadModel(
+            "./models/PP-StructrureV2_SLANet_plus_cnn.param",
+            "./models/PP-StructrureV2_SLANet_plus_cnn.bin",
+            "./models/PP-StructrureV2_SLANet_plus_slahead.param",
+            "./models/PP-StructrureV2_SLANet_plus_slahead.bin",
+            "./models/table_structure_dict_ch.txt")) {
+        std::cerr << "Failed to load table models" << std::endl;
+        return -1;
+    }
+    LiteOCR::StartupStats table_stats = table.warmup();
+    print("table engine", table_stats);
+    if (!table_stats.warm || table_stats.stages.size() != 1 || table_stats.stages[0].warmupMs <= 0) failed++;
+
+    return failed == 0 ? 0 : 1;
+}
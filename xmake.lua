@@ -47,4 +47,20 @@ add_test("baseocr")
 add_test("docori")
 add_test("uvdoc")
 add_test("slanet")
-add_test("tableocr")
\ No newline at end of file
+add_test("tableocr")
+add_test("dbpost")
+add_test("ctcdecoder")
+add_test("concurrent")
+add_test("batch")
+add_test("stream")
+add_test("async")
+add_test("scheduler")
+add_test("cancel")
+add_test("allocator")
+add_test("pixelformat")
+add_test("decode")
+add_test("mmap")
+add_test("bundle")
+add_test("warmup")
+add_test("language")
+add_test("reload")
\ No newline at end of file